@@ -0,0 +1,68 @@
+#pragma once
+#include <assert.h>
+
+#include <utility>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief Dial のバケットキュー
+ * @details 最後に取り出したキーを d として [d, d + C] のキーのみ入れられる。
+ * 循環する C + 1 個のバケットを使う。pop ならし O(1 + (キーの増分))
+ */
+template <class Val> class BucketQueue {
+    std::vector<std::vector<Val>> buckets;
+    i64 cur = 0;
+    u32 sz = 0;
+
+  public:
+    BucketQueue() : buckets(1) {}
+    /**
+     * @param max_step 一度に増えるキーの最大値 C
+     * @param init_key 最初に取り出せるキーの下限
+     */
+    explicit BucketQueue(i64 max_step, i64 init_key = 0)
+        : buckets(max_step + 1), cur(init_key) {}
+
+    bool empty() const { return sz == 0; }
+    u32 size() const { return sz; }
+
+    void clear() {
+        for (auto &b : buckets)
+            b.clear();
+        cur = 0;
+        sz = 0;
+    }
+
+    /**
+     * @brief 空にして max_step, init_key を設定し直す
+     * @details バケットの確保済み領域は再利用する
+     */
+    void reset(i64 max_step, i64 init_key = 0) {
+        clear();
+        buckets.resize(max_step + 1);
+        cur = init_key;
+    }
+
+    void push(i64 key, const Val &val) {
+        assert(cur <= key && key - cur < (i64)buckets.size());
+        ++sz;
+        buckets[key % buckets.size()].push_back(val);
+    }
+
+    std::pair<i64, Val> pop() {
+        assert(sz > 0);
+        while (buckets[cur % buckets.size()].empty())
+            ++cur;
+        auto &b = buckets[cur % buckets.size()];
+        Val ret = b.back();
+        b.pop_back();
+        --sz;
+        return {cur, ret};
+    }
+};
+
+} // namespace gandalfr
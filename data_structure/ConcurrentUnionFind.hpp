@@ -0,0 +1,87 @@
+#pragma once
+#include <assert.h>
+
+#include <atomic>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 複数のスレッドから同時に使える UnionFind
+ * @details 親の配列を CAS で書き換える lock-free な実装。根どうしは番号を
+ * 混ぜた優先度の小さい方を大きい方の子にし (union by index)、leader では
+ * path splitting を行う。leader, isSame, unite は並行に呼んでよい
+ */
+class ConcurrentUnionFind {
+  private:
+    i32 N;
+    mutable std::vector<i32> par;
+    i32 group_num;
+
+    static constexpr auto relaxed = std::memory_order_relaxed;
+
+    // 番号の全単射で決まる優先度。番号順に繋いだときの偏りを避ける
+    static u32 priority(i32 x) { return (u32)x * 0x9E3779B9u; }
+    i32 parent(i32 x) const {
+        return std::atomic_ref<i32>(par[x]).load(relaxed);
+    }
+
+  public:
+    ConcurrentUnionFind() : N(0), group_num(0) {}
+    ConcurrentUnionFind(i32 n) : N(n), par(n), group_num(n) {
+        std::iota(par.begin(), par.end(), 0);
+    }
+
+    i32 leader(i32 x) const {
+        while (true) {
+            i32 p = parent(x);
+            if (p == x)
+                return x;
+            // 祖父に付け替えてから親に進む
+            i32 g = parent(p), expected = p;
+            if (p != g)
+                std::atomic_ref<i32>(par[x]).compare_exchange_weak(
+                    expected, g, relaxed);
+            x = p;
+        }
+    }
+
+    bool isSame(i32 x, i32 y) const {
+        while (true) {
+            x = leader(x), y = leader(y);
+            if (x == y)
+                return true;
+            // x が根のままなら、この時点で別のグループだった
+            if (parent(x) == x)
+                return false;
+        }
+    }
+
+    bool unite(i32 x, i32 y) {
+        while (true) {
+            x = leader(x), y = leader(y);
+            if (x == y)
+                return false;
+            if (priority(x) > priority(y))
+                std::swap(x, y);
+            i32 expected = x;
+            if (std::atomic_ref<i32>(par[x]).compare_exchange_strong(expected,
+                                                                     y)) {
+                std::atomic_ref<i32>(group_num).fetch_sub(1, relaxed);
+                return true;
+            }
+        }
+    }
+
+    i32 size() const { return N; }
+
+    /**
+     * @attention 他のスレッドが unite していない時点で呼ぶこと
+     */
+    i32 numGroups() const { return group_num; }
+};
+} // namespace gandalfr
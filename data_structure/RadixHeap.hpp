@@ -0,0 +1,68 @@
+#pragma once
+#include <assert.h>
+
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 単調な (最後に取り出したキー以上のキーしか入れない) 最小ヒープ
+ * @details キーは符号なし整数。push O(1)、pop ならし O(log C)
+ */
+template <class Key, class Val> class RadixHeap {
+    static_assert(std::is_unsigned_v<Key>, "Key must be unsigned.");
+    static constexpr i32 B = std::numeric_limits<Key>::digits;
+
+    std::array<std::vector<std::pair<Key, Val>>, B + 1> buckets;
+    Key last = 0;
+    u32 sz = 0;
+
+    static i32 bucketIndex(Key x) {
+        return x == 0 ? 0 : 64 - __builtin_clzll((u64)x);
+    }
+
+  public:
+    bool empty() const { return sz == 0; }
+    u32 size() const { return sz; }
+
+    void clear() {
+        for (auto &b : buckets)
+            b.clear();
+        last = 0;
+        sz = 0;
+    }
+
+    void push(Key key, const Val &val) {
+        assert(last <= key);
+        ++sz;
+        buckets[bucketIndex(key ^ last)].emplace_back(key, val);
+    }
+
+    std::pair<Key, Val> pop() {
+        assert(sz > 0);
+        if (buckets[0].empty()) {
+            i32 i = 1;
+            while (buckets[i].empty())
+                ++i;
+            last = buckets[i][0].first;
+            for (auto &p : buckets[i])
+                if (p.first < last)
+                    last = p.first;
+            for (auto &p : buckets[i])
+                buckets[bucketIndex(p.first ^ last)].push_back(p);
+            buckets[i].clear();
+        }
+        --sz;
+        auto ret = buckets[0].back();
+        buckets[0].pop_back();
+        return ret;
+    }
+};
+
+} // namespace gandalfr
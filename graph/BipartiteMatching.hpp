@@ -0,0 +1,385 @@
+#pragma once
+#include <bit>
+#include <cassert>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "../types.hpp"
+#include "Graph.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 二部グラフの最大マッチング (Hopcroft-Karp 法)
+ * @details 左側 L 頂点、右側 R 頂点。辺は左から右への隣接リストを平坦な
+ * 配列で持つ。解く前に貪欲にマッチングを作ってから増加路を探す
+ */
+class BipartiteMatching {
+  private:
+    i32 L = 0, R = 0;
+    std::vector<i32> _src, _dst;
+    std::vector<i32> _ofs, _to;
+    std::vector<i32> _mate_l, _mate_r;
+    bool built = false;
+
+    void build() {
+        if (built)
+            return;
+        _ofs.assign(L + 1, 0);
+        for (i32 u : _src)
+            ++_ofs[u + 1];
+        for (i32 u = 0; u < L; ++u)
+            _ofs[u + 1] += _ofs[u];
+        std::vector<i32> pos(_ofs.begin(), _ofs.end() - 1);
+        _to.resize(_src.size());
+        for (i32 i = 0; i < (i32)_src.size(); ++i)
+            _to[pos[_src[i]]++] = _dst[i];
+        built = true;
+    }
+
+    // 空いている頂点同士を貪欲に結ぶ
+    void greedy() {
+        for (i32 u = 0; u < L; ++u) {
+            if (_mate_l[u] != -1)
+                continue;
+            for (i32 a = _ofs[u]; a < _ofs[u + 1]; ++a) {
+                if (_mate_r[_to[a]] == -1) {
+                    _mate_l[u] = _to[a], _mate_r[_to[a]] = u;
+                    break;
+                }
+            }
+        }
+    }
+
+  public:
+    BipartiteMatching() = default;
+    BipartiteMatching(i32 l, i32 r)
+        : L(l), R(r), _mate_l(l, -1), _mate_r(r, -1) {}
+    /**
+     * @param adj adj[u] は左の頂点 u に隣接する右の頂点のリスト
+     * @param r 右側の頂点数
+     */
+    BipartiteMatching(const std::vector<std::vector<i32>> &adj, i32 r)
+        : BipartiteMatching(adj.size(), r) {
+        for (i32 u = 0; u < L; ++u)
+            for (i32 v : adj[u])
+                addEdge(u, v);
+    }
+
+    i32 numLeft() const { return L; }
+    i32 numRight() const { return R; }
+    i32 numEdges() const { return _src.size(); }
+
+    /**
+     * @brief 左の頂点 u と右の頂点 v を結ぶ
+     */
+    void addEdge(i32 u, i32 v) {
+        assert(0 <= u && u < L && 0 <= v && v < R);
+        built = false;
+        _src.push_back(u);
+        _dst.push_back(v);
+    }
+
+    /**
+     * @brief Hopcroft-Karp 法 O(E sqrt(V))
+     * @details 現在のマッチングから続けて増やす。増加路の探索は明示的な
+     * スタックで行う
+     * @return マッチングの大きさ
+     */
+    i32 hopcroftKarp() {
+        build();
+        greedy();
+        std::vector<i32> dist(L), que(L), iter(L), stk;
+        while (true) {
+            // 空いている左の頂点からの交互路の層を作る
+            i32 qt = 0, lim = std::numeric_limits<i32>::max();
+            for (i32 u = 0; u < L; ++u) {
+                dist[u] = (_mate_l[u] == -1 ? 0 : -1);
+                if (dist[u] == 0)
+                    que[qt++] = u;
+            }
+            for (i32 qh = 0; qh < qt && dist[que[qh]] < lim; ++qh) {
+                i32 u = que[qh];
+                for (i32 a = _ofs[u]; a < _ofs[u + 1]; ++a) {
+                    i32 w = _mate_r[_to[a]];
+                    if (w == -1) {
+                        lim = dist[u];
+                    } else if (dist[w] == -1) {
+                        dist[w] = dist[u] + 1;
+                        que[qt++] = w;
+                    }
+                }
+            }
+            if (lim == std::numeric_limits<i32>::max())
+                break;
+
+            // 最短の増加路を頂点素に取れるだけ取る
+            for (i32 u = 0; u < L; ++u)
+                iter[u] = _ofs[u];
+            for (i32 root = 0; root < L; ++root) {
+                if (_mate_l[root] != -1 || dist[root] != 0)
+                    continue;
+                stk.assign(1, root);
+                while (!stk.empty()) {
+                    i32 u = stk.back();
+                    if (iter[u] == _ofs[u + 1]) {
+                        dist[u] = -1;
+                        stk.pop_back();
+                        continue;
+                    }
+                    i32 w = _mate_r[_to[iter[u]]];
+                    if (w == -1) {
+                        for (i32 x : stk) {
+                            i32 v = _to[iter[x]];
+                            _mate_l[x] = v, _mate_r[v] = x;
+                            dist[x] = -1;
+                        }
+                        break;
+                    }
+                    if (dist[w] == dist[u] + 1 && dist[w] <= lim)
+                        stk.push_back(w);
+                    else
+                        ++iter[u];
+                }
+            }
+        }
+        return size();
+    }
+
+    /**
+     * @brief 隣接行列をビット列で持つ Hopcroft-Karp 法 O(V^2.5 / 64)
+     * @details 密なグラフ向け。未訪問の右の頂点の集合との積を 64 頂点ずつ
+     * まとめて取る。現在のマッチングから続けて増やす
+     * @return マッチングの大きさ
+     */
+    i32 hopcroftKarpDense() {
+        build();
+        greedy();
+        if (L == 0 || R == 0)
+            return 0;
+        const i32 W = (R + 63) / 64;
+        std::vector<u64> adj((size_t)L * W, 0);
+        for (i32 u = 0; u < L; ++u)
+            for (i32 a = _ofs[u]; a < _ofs[u + 1]; ++a)
+                adj[(size_t)u * W + _to[a] / 64] |= 1ULL << (_to[a] % 64);
+        std::vector<u64> full(W, ~0ULL), unvis(W), alive(W), layer;
+        if (R % 64)
+            full[W - 1] = (1ULL << (R % 64)) - 1;
+        std::vector<i32> dist(L), front, next, iter(L), stk, path;
+        while (true) {
+            // layer[k] は k 番目の層から辿る右の頂点の集合
+            unvis = full;
+            layer.clear();
+            front.clear();
+            for (i32 u = 0; u < L; ++u) {
+                dist[u] = (_mate_l[u] == -1 ? 0 : -1);
+                if (dist[u] == 0)
+                    front.push_back(u);
+            }
+            bool found = false;
+            while (!front.empty() && !found) {
+                i32 k = layer.size() / W;
+                layer.resize(layer.size() + W, 0);
+                u64 *nw = layer.data() + (size_t)k * W;
+                for (i32 u : front) {
+                    const u64 *row = adj.data() + (size_t)u * W;
+                    for (i32 i = 0; i < W; ++i) {
+                        nw[i] |= row[i] & unvis[i];
+                        unvis[i] &= ~row[i];
+                    }
+                }
+                next.clear();
+                for (i32 i = 0; i < W; ++i) {
+                    for (u64 x = nw[i]; x; x &= x - 1) {
+                        i32 w = _mate_r[i * 64 + std::countr_zero(x)];
+                        if (w == -1) {
+                            found = true;
+                        } else {
+                            dist[w] = k + 1;
+                            next.push_back(w);
+                        }
+                    }
+                }
+                std::swap(front, next);
+            }
+            if (!found)
+                break;
+
+            const i32 K = layer.size() / W;
+            alive = full;
+            for (i32 u = 0; u < L; ++u)
+                iter[u] = 0;
+            for (i32 root = 0; root < L; ++root) {
+                if (_mate_l[root] != -1 || dist[root] != 0)
+                    continue;
+                stk.assign(1, root);
+                path.clear();
+                while (!stk.empty()) {
+                    i32 u = stk.back(), k = dist[u];
+                    const u64 *row = adj.data() + (size_t)u * W;
+                    const u64 *lay = layer.data() + (size_t)k * W;
+                    u64 x = 0;
+                    while (iter[u] < W &&
+                           !(x = row[iter[u]] & lay[iter[u]] & alive[iter[u]]))
+                        ++iter[u];
+                    if (x == 0) {
+                        stk.pop_back();
+                        if (!path.empty())
+                            path.pop_back();
+                        continue;
+                    }
+                    i32 v = iter[u] * 64 + std::countr_zero(x);
+                    alive[v / 64] &= ~(1ULL << (v % 64));
+                    i32 w = _mate_r[v];
+                    if (w == -1) {
+                        path.push_back(v);
+                        for (i32 j = 0; j < (i32)stk.size(); ++j) {
+                            _mate_l[stk[j]] = path[j];
+                            _mate_r[path[j]] = stk[j];
+                        }
+                        break;
+                    }
+                    if (k + 1 < K) {
+                        path.push_back(v);
+                        stk.push_back(w);
+                    }
+                }
+            }
+        }
+        return size();
+    }
+
+    /**
+     * @return マッチングの大きさ
+     */
+    i32 size() const {
+        i32 ret = 0;
+        for (i32 v : _mate_l)
+            ret += (v != -1);
+        return ret;
+    }
+
+    /**
+     * @return 左の頂点 u の相手 (いなければ -1)
+     */
+    i32 mateLeft(i32 u) const { return _mate_l[u]; }
+    /**
+     * @return 右の頂点 v の相手 (いなければ -1)
+     */
+    i32 mateRight(i32 v) const { return _mate_r[v]; }
+
+    /**
+     * @return マッチングに使われている {左の頂点, 右の頂点} の組
+     */
+    std::vector<std::pair<i32, i32>> matching() const {
+        std::vector<std::pair<i32, i32>> ret;
+        for (i32 u = 0; u < L; ++u)
+            if (_mate_l[u] != -1)
+                ret.emplace_back(u, _mate_l[u]);
+        return ret;
+    }
+
+    /**
+     * @brief 最小頂点被覆 O(V+E)
+     * @details 空いている左の頂点から交互路で届く頂点の集合を Z として、
+     * (左 \ Z) と (右 ∩ Z) を返す (König の定理)
+     * @attention 最大マッチングを求めた後に呼ぶこと
+     * @return {被覆に含まれる左の頂点, 被覆に含まれる右の頂点}
+     */
+    std::pair<std::vector<i32>, std::vector<i32>> minVertexCover() {
+        build();
+        std::vector<bool> zl(L, false), zr(R, false);
+        std::vector<i32> que;
+        for (i32 u = 0; u < L; ++u) {
+            if (_mate_l[u] == -1) {
+                zl[u] = true;
+                que.push_back(u);
+            }
+        }
+        for (i32 qh = 0; qh < (i32)que.size(); ++qh) {
+            i32 u = que[qh];
+            for (i32 a = _ofs[u]; a < _ofs[u + 1]; ++a) {
+                i32 v = _to[a];
+                if (zr[v])
+                    continue;
+                zr[v] = true;
+                i32 w = _mate_r[v];
+                if (w != -1 && !zl[w]) {
+                    zl[w] = true;
+                    que.push_back(w);
+                }
+            }
+        }
+        std::vector<i32> cl, cr;
+        for (i32 u = 0; u < L; ++u)
+            if (!zl[u])
+                cl.push_back(u);
+        for (i32 v = 0; v < R; ++v)
+            if (zr[v])
+                cr.push_back(v);
+        return {cl, cr};
+    }
+};
+
+GRAPH_TEMPLATE
+std::tuple<std::vector<i32>, std::vector<bool>>
+GRAPH_TYPE::bipartiteMatching(bool dense) const {
+    // 向きを無視して 2 色に塗り、色 0 を左、色 1 を右とする
+    std::vector<std::vector<i32>> adj(N);
+    for (auto &e : E) {
+        adj[e->v0].push_back(e->v1);
+        adj[e->v1].push_back(e->v0);
+    }
+    std::vector<i32> col(N, -1), idx(N), que;
+    i32 l = 0, r = 0;
+    for (i32 s = 0; s < N; ++s) {
+        if (col[s] != -1)
+            continue;
+        col[s] = 0;
+        que.assign(1, s);
+        for (i32 qh = 0; qh < (i32)que.size(); ++qh) {
+            i32 x = que[qh];
+            for (i32 y : adj[x]) {
+                assert(col[y] != col[x]);
+                if (col[y] == -1) {
+                    col[y] = !col[x];
+                    que.push_back(y);
+                }
+            }
+        }
+    }
+    std::vector<i32> left, right;
+    for (i32 v = 0; v < N; ++v) {
+        idx[v] = (col[v] == 0 ? l++ : r++);
+        (col[v] == 0 ? left : right).push_back(v);
+    }
+
+    BipartiteMatching M(l, r);
+    for (auto &e : E) {
+        i32 a = e->v0, b = e->v1;
+        if (col[a] == 1)
+            std::swap(a, b);
+        M.addEdge(idx[a], idx[b]);
+    }
+    if (dense)
+        M.hopcroftKarpDense();
+    else
+        M.hopcroftKarp();
+
+    std::vector<i32> mate(N, -1);
+    for (auto [u, v] : M.matching()) {
+        mate[left[u]] = right[v];
+        mate[right[v]] = left[u];
+    }
+    std::vector<bool> cover(N, false);
+    auto [cl, cr] = M.minVertexCover();
+    for (i32 u : cl)
+        cover[left[u]] = true;
+    for (i32 v : cr)
+        cover[right[v]] = true;
+    return {mate, cover};
+}
+
+} // namespace gandalfr
@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <vector>
+
+#include "../types.hpp"
+#include "ResidualGraph.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 流量の下限と上限を持つ辺と、ノードの供給量を扱うフロー
+ * @details 下限 l、上限 r の辺は容量 r - l の辺と端点の過不足に置き換え、
+ * 過不足は超頂点 S, T との辺で吸収する。残余グラフと S, T との辺は一度
+ * だけ作り、上下限や供給量を変えて解き直すときは容量を書き換えるだけで
+ * 済ませる
+ */
+class BoundedFlowGraph {
+  public:
+    using Flow = ResidualGraph::Flow;
+
+  private:
+    i32 N = 0;
+    // 残余グラフの辺 v は S -> v、N + v は v -> T
+    ResidualGraph R;
+    std::vector<Flow> _lower, _upper, _supply, _excess;
+    std::vector<i32> _id; // 辺の残余グラフでの番号
+    // s-t フロー用の容量無限の辺 {s, t, 残余グラフでの t -> s の辺の番号}
+    std::vector<std::tuple<i32, i32, i32>> _back;
+
+    // 流量を 0 に戻し、下限の分を差し引いた過不足を S, T との辺に設定する
+    // 過不足の合計が 0 でなければ -1、そうでなければ S から流すべき量を返す
+    Flow prepare() {
+        R.resetFlow();
+        std::copy(_supply.begin(), _supply.end(), _excess.begin());
+        for (i32 i = 0; i < (i32)_id.size(); ++i) {
+            R.setCapacity(_id[i], _upper[i] - _lower[i]);
+            _excess[R.edgeFrom(_id[i])] -= _lower[i];
+            _excess[R.edgeTo(_id[i])] += _lower[i];
+        }
+        for (auto [s, t, j] : _back)
+            R.setCapacity(j, 0);
+        Flow need = 0, sum = 0;
+        for (i32 v = 0; v < N; ++v) {
+            R.setCapacity(v, std::max<Flow>(_excess[v], 0));
+            R.setCapacity(N + v, std::max<Flow>(-_excess[v], 0));
+            need += std::max<Flow>(_excess[v], 0);
+            sum += _excess[v];
+        }
+        return (sum == 0 ? need : -1);
+    }
+
+  public:
+    BoundedFlowGraph() = default;
+    explicit BoundedFlowGraph(i32 n)
+        : N(n), R(n + 2, 2 * n), _supply(n, 0), _excess(n) {
+        for (i32 v = 0; v < N; ++v)
+            R.addEdge(N, v, 0);
+        for (i32 v = 0; v < N; ++v)
+            R.addEdge(v, N + 1, 0);
+    }
+
+    /**
+     * @return ノードの数
+     */
+    i32 numNodes() const { return N; }
+
+    /**
+     * @return 辺の数
+     */
+    i32 numEdges() const { return _id.size(); }
+
+    /**
+     * @brief 流量が [lower, upper] に収まる辺を追加する
+     * @return 辺の番号
+     */
+    i32 addEdge(i32 from, i32 to, Flow lower, Flow upper) {
+        assert(0 <= lower && lower <= upper);
+        _lower.push_back(lower);
+        _upper.push_back(upper);
+        _id.push_back(R.addEdge(from, to, upper - lower));
+        return _id.size() - 1;
+    }
+
+    /**
+     * @brief 辺 i の流量の範囲を [lower, upper] に変更する O(1)
+     * @details 次に解くときに反映される
+     */
+    void setBounds(i32 i, Flow lower, Flow upper) {
+        assert(0 <= lower && lower <= upper);
+        _lower[i] = lower, _upper[i] = upper;
+    }
+
+    /**
+     * @brief ノード v の供給量を b にする (負なら需要)
+     * @details v から出る流量と入る流量の差が b になるように流す
+     */
+    void setSupply(i32 v, Flow b) { _supply[v] = b; }
+
+    /**
+     * @brief 上下限と供給量を満たす流れが存在するか O(Dinic)
+     * @details 存在すれば各辺の流量は flow(i) で得られる
+     */
+    bool feasible() {
+        Flow need = prepare();
+        return need >= 0 && R.dinic(N, N + 1) == need;
+    }
+
+    /**
+     * @brief 上下限と供給量を満たす s-t フローの最大流量 O(Dinic)
+     * @details t -> s に容量無限の辺を張って実行可能な流れを求め、その
+     * 残余グラフで s から t へ流せるだけ流す。t -> s の辺は (s, t) ごとに
+     * 一度だけ作る
+     * @return 最大流量。実行可能な流れがなければ -1
+     */
+    Flow maxFlow(i32 s, i32 t) {
+        assert(s != t);
+        auto it = std::find_if(_back.begin(), _back.end(), [&](auto &b) {
+            return std::get<0>(b) == s && std::get<1>(b) == t;
+        });
+        i32 j = (it != _back.end() ? std::get<2>(*it)
+                                   : R.addEdge(t, s, ResidualGraph::FMAX));
+        if (it == _back.end())
+            _back.emplace_back(s, t, j);
+        Flow need = prepare();
+        R.setCapacity(j, ResidualGraph::FMAX);
+        if (need < 0 || R.dinic(N, N + 1) != need)
+            return -1;
+        // t -> s の辺の流量も打ち消されるので、これが s-t の流量になる
+        return R.dinic(s, t);
+    }
+
+    /**
+     * @return 最後に解いたときの辺 i の流量
+     */
+    Flow flow(i32 i) const { return _lower[i] + R.flow(_id[i]); }
+
+    Flow lower(i32 i) const { return _lower[i]; }
+    Flow upper(i32 i) const { return _upper[i]; }
+    Flow supply(i32 v) const { return _supply[v]; }
+};
+
+} // namespace gandalfr
@@ -0,0 +1,177 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include "../other/parallel.hpp"
+#include "CsrGraph.hpp"
+#include "Graph.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 無向森の重心分解
+ * @details 重心木の親と段 (重心木での深さ) を求め、各ノード v について
+ * 段 k = 0, ..., level(v) の重心の祖先とそこまでの距離を、ノードごとに
+ * 連続する平坦な配列に持つ。構築は非再帰で O(N log N)、メモリも
+ * O(N log N)
+ */
+template <bool is_weighted> class CentroidDecomposition {
+  private:
+    using EdgeType = Edge<is_weighted>;
+    using Cost = typename EdgeType::Cost;
+    using GraphType = Graph<is_weighted, UNDIRECTED>;
+
+    i32 N = 0;
+    std::vector<i32> _par, _level;
+    // ノード v の段 k の情報は _off[v] + k の位置にある
+    std::vector<i32> _off, _anc;
+    std::vector<Cost> _dist;
+    std::vector<Cost> _best; // 重心ごとの、印の付いたノードへの最短距離
+
+    // 重心木の親と段を求める
+    void decompose(const CsrGraph<is_weighted, UNDIRECTED> &H) {
+        std::vector<i32> order, bpar(N), sz(N);
+        // {成分の中のノード, 重心木の親, 段}
+        std::vector<std::tuple<i32, i32, i32>> stk;
+        for (i32 s = 0; s < N; ++s) {
+            if (_level[s] != -1)
+                continue;
+            stk.emplace_back(s, -1, 0);
+            while (!stk.empty()) {
+                auto [r, p, lv] = stk.back();
+                stk.pop_back();
+                // 分解済みのノードを除いた成分を BFS で集める
+                order.assign(1, r);
+                bpar[r] = -1;
+                for (u32 i = 0; i < order.size(); ++i) {
+                    i32 v = order[i];
+                    sz[v] = 1;
+                    for (i32 a = H.arcBegin(v); a < H.arcEnd(v); ++a) {
+                        i32 w = H.to(a);
+                        if (w != bpar[v] && _level[w] == -1)
+                            bpar[w] = v, order.push_back(w);
+                    }
+                }
+                for (i32 i = order.size() - 1; i > 0; --i)
+                    sz[bpar[order[i]]] += sz[order[i]];
+                // 成分の半分より大きい部分木がある限りそちらへ進む
+                const i32 total = order.size();
+                i32 c = r;
+                for (bool moved = true; moved;) {
+                    moved = false;
+                    for (i32 a = H.arcBegin(c); a < H.arcEnd(c); ++a) {
+                        i32 w = H.to(a);
+                        if (w != bpar[c] && _level[w] == -1 &&
+                            sz[w] * 2 > total) {
+                            c = w, moved = true;
+                            break;
+                        }
+                    }
+                }
+                _par[c] = p, _level[c] = lv;
+                for (i32 a = H.arcBegin(c); a < H.arcEnd(c); ++a)
+                    if (_level[H.to(a)] == -1)
+                        stk.emplace_back(H.to(a), c, lv + 1);
+            }
+        }
+    }
+
+  public:
+    static constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+
+    CentroidDecomposition() = default;
+    CentroidDecomposition(const GraphType &G, i32 num_threads = 1) {
+        init(G, num_threads);
+    }
+
+    /**
+     * @brief 重心分解する O(N log N)
+     * @details 各重心からの距離は、重心ごとに段の大きいノードだけを辿る
+     * BFS で求める。書き込む位置は重心ごとに重ならないので、重心を
+     * num_threads 本のスレッドで分担する
+     */
+    void init(const GraphType &G, i32 num_threads = 1) {
+        N = G.numNodes();
+        CsrGraph<is_weighted, UNDIRECTED> H(G);
+        _par.assign(N, -1);
+        _level.assign(N, -1);
+        decompose(H);
+
+        _off.assign(N + 1, 0);
+        for (i32 v = 0; v < N; ++v)
+            _off[v + 1] = _off[v] + _level[v] + 1;
+        _anc.assign(_off[N], 0);
+        _dist.assign(_off[N], 0);
+        const i32 K = std::max(1, std::min(num_threads * 8, N));
+        parallelFor(K, num_threads, [&](i32 k) {
+            std::vector<std::tuple<i32, i32, Cost>> que;
+            for (i32 c = (i64)N * k / K; c < (i64)N * (k + 1) / K; ++c) {
+                const i32 lv = _level[c];
+                que.assign(1, {c, -1, 0});
+                for (u32 i = 0; i < que.size(); ++i) {
+                    auto [v, p, d] = que[i];
+                    _anc[_off[v] + lv] = c;
+                    _dist[_off[v] + lv] = d;
+                    for (i32 a = H.arcBegin(v); a < H.arcEnd(v); ++a) {
+                        i32 w = H.to(a);
+                        if (w != p && _level[w] > lv)
+                            que.emplace_back(w, v, d + H.cost(a));
+                    }
+                }
+            }
+        });
+        _best.assign(N, CMAX);
+    }
+
+    i32 numNodes() const { return N; }
+
+    /**
+     * @return 重心木での親 (成分の最初の重心なら -1)
+     */
+    i32 parent(i32 v) const { return _par[v]; }
+
+    /**
+     * @return 重心木での深さ (最初の重心が 0)
+     */
+    i32 level(i32 v) const { return _level[v]; }
+
+    /**
+     * @return v の重心木での祖先のうち、段が k のもの (k <= level(v))
+     */
+    i32 ancestor(i32 v, i32 k) const { return _anc[_off[v] + k]; }
+
+    /**
+     * @return v から ancestor(v, k) までの距離 (k <= level(v))
+     */
+    Cost distance(i32 v, i32 k) const { return _dist[_off[v] + k]; }
+
+    /**
+     * @brief v に印を付ける O(log N)
+     */
+    void mark(i32 v) {
+        for (i32 i = _off[v]; i < _off[v + 1]; ++i)
+            _best[_anc[i]] = std::min(_best[_anc[i]], _dist[i]);
+    }
+
+    /**
+     * @brief 全ての印を外す O(N)
+     */
+    void clearMarks() { std::fill(_best.begin(), _best.end(), CMAX); }
+
+    /**
+     * @brief v から印の付いたノードまでの最短距離 O(log N)
+     * @details v と u の間のパスは、両者の重心木での LCA を通る
+     * @return 同じ成分に印の付いたノードがなければ CMAX
+     */
+    Cost nearestMarked(i32 v) const {
+        Cost ret = CMAX;
+        for (i32 i = _off[v]; i < _off[v + 1]; ++i)
+            if (_best[_anc[i]] != CMAX)
+                ret = std::min(ret, _best[_anc[i]] + _dist[i]);
+        return ret;
+    }
+};
+
+} // namespace gandalfr
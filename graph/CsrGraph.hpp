@@ -0,0 +1,566 @@
+#pragma once
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+#include "../data_structure/UnionFind.hpp"
+#include "Graph.hpp"
+#include "shortestPath.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 隣接リストを CSR 形式で保持する静的なグラフ
+ * @details ノード v の隣接辺は [arcBegin(v), arcEnd(v)) の区間に詰めて並ぶ。
+ * 各 arc は行き先 to、コスト cost、元の辺の添字 edgeIdx を持つ。
+ * @attention 構築後に辺を追加することはできない
+ */
+template <bool is_weighted, bool is_directed> class CsrGraph {
+  public:
+    using EdgeType = Edge<is_weighted>;
+    using Cost = typename EdgeType::Cost;
+
+  private:
+    i32 N = 0;
+    std::vector<i32> _ofs, _to, _eidx;
+    std::vector<Cost> _cost; // 重みなしのときは空
+    std::vector<EdgeType> E;
+    Cost cost_sum = 0;
+    // 辺のコストの最小値と最大値 (0 も含めた範囲)。キューの選択に使う
+    Cost cost_min = 0, cost_max = 0;
+    static constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+
+    // E から O(N+M) で隣接配列を詰める
+    void build() {
+        _ofs.assign(N + 1, 0);
+        for (auto &e : E) {
+            ++_ofs[e.v0 + 1];
+            if constexpr (!is_directed) {
+                if (e.v0 != e.v1)
+                    ++_ofs[e.v1 + 1];
+            }
+        }
+        for (i32 i = 0; i < N; ++i)
+            _ofs[i + 1] += _ofs[i];
+
+        i32 num_arcs = _ofs[N];
+        _to.resize(num_arcs);
+        _eidx.resize(num_arcs);
+        if constexpr (is_weighted)
+            _cost.resize(num_arcs);
+
+        std::vector<i32> pos(_ofs.begin(), _ofs.end() - 1);
+        auto put = [&](i32 src, i32 dst, i32 idx) {
+            i32 p = pos[src]++;
+            _to[p] = dst;
+            _eidx[p] = idx;
+            if constexpr (is_weighted)
+                _cost[p] = E[idx].cost;
+        };
+        cost_sum = cost_min = cost_max = 0;
+        for (i32 i = 0; i < (i32)E.size(); ++i) {
+            put(E[i].v0, E[i].v1, i);
+            if constexpr (!is_directed) {
+                if (E[i].v0 != E[i].v1)
+                    put(E[i].v1, E[i].v0, i);
+            }
+            cost_sum += E[i].cost;
+            chmin(cost_min, E[i].cost);
+            chmax(cost_max, E[i].cost);
+        }
+    }
+
+  public:
+    CsrGraph() : _ofs(1, 0) {}
+
+    /**
+     * @brief Graph から O(N+M) で構築
+     * @attention 各ノードの隣接辺の順序は Graph と一致する
+     */
+    explicit CsrGraph(const Graph<is_weighted, is_directed> &G)
+        : N(G.numNodes()) {
+        E.reserve(G.numEdges());
+        for (auto &e : G.getAllEdges())
+            E.push_back(*e);
+        build();
+    }
+
+    /**
+     * @brief 辺のリストから O(N+M) で構築
+     * @attention 辺の id は保持される
+     */
+    CsrGraph(i32 n, std::vector<EdgeType> edges) : N(n), E(std::move(edges)) {
+        build();
+    }
+
+    /**
+     * @return ノードの数
+     */
+    i32 numNodes() const { return N; }
+
+    /**
+     * @return 辺の数
+     */
+    i32 numEdges() const { return E.size(); }
+
+    /**
+     * @return ノード v の次数
+     */
+    i32 degree(i32 v) const { return _ofs[v + 1] - _ofs[v]; }
+
+    i32 arcBegin(i32 v) const { return _ofs[v]; }
+    i32 arcEnd(i32 v) const { return _ofs[v + 1]; }
+    i32 to(i32 a) const { return _to[a]; }
+    Cost cost(i32 a) const {
+        if constexpr (is_weighted) {
+            return _cost[a];
+        } else {
+            return 1;
+        }
+    }
+    i32 edgeIdx(i32 a) const { return _eidx[a]; }
+
+    /**
+     * @return グラフ全体の辺のリストの const 参照
+     */
+    const std::vector<EdgeType> &getAllEdges() const { return E; }
+    /**
+     * @return idx 番目に張られた辺の const 参照
+     */
+    const EdgeType &getEdge(i32 idx) const { return E[idx]; }
+
+    /**
+     * @return グラフの重み
+     */
+    Cost weight() const { return cost_sum; }
+
+    /**
+     * @brief Graph に戻す
+     */
+    Graph<is_weighted, is_directed> toGraph() const {
+        Graph<is_weighted, is_directed> ret(N, E.size());
+        for (auto &e : E)
+            ret.addEdge(e);
+        return ret;
+    }
+
+    CsrGraph rev() const {
+        if constexpr (!is_directed) {
+            return *this;
+        } else {
+            std::vector<EdgeType> R;
+            R.reserve(E.size());
+            for (auto &e : E)
+                R.push_back(e.rev());
+            return CsrGraph(N, std::move(R));
+        }
+    }
+
+  private:
+    HeapPolicy selectHeap(std::span<const std::pair<i32, Cost>> sources) const {
+        return internal::selectHeap(cost_min, cost_max, sources);
+    }
+
+    auto adjacency() const {
+        return [this](i32 cu, auto &&f) {
+            for (i32 a = _ofs[cu]; a < _ofs[cu + 1]; ++a)
+                f(_to[a], cost(a), &E[_eidx[a]]);
+        };
+    }
+
+    template <HeapPolicy policy>
+    void shortestPathImpl(ShortestPathWorkspace<is_weighted> &ws,
+                          std::span<const std::pair<i32, Cost>> sources,
+                          std::span<const i32> targets, Cost bound) const {
+        if constexpr (!is_weighted) {
+            internal::bfs(ws, adjacency(), sources, targets, bound);
+        } else if constexpr (policy == HeapPolicy::AUTO) {
+            switch (selectHeap(sources)) {
+            case HeapPolicy::RADIX:
+                shortestPathImpl<HeapPolicy::RADIX>(ws, sources, targets,
+                                                    bound);
+                break;
+            case HeapPolicy::BUCKET:
+                shortestPathImpl<HeapPolicy::BUCKET>(ws, sources, targets,
+                                                     bound);
+                break;
+            default:
+                shortestPathImpl<HeapPolicy::BINARY>(ws, sources, targets,
+                                                     bound);
+            }
+        } else {
+            internal::dijkstra<policy>(ws, adjacency(), sources, targets,
+                                       bound, cost_max);
+        }
+    }
+
+  public:
+    /**
+     * @brief 最短距離を計算する
+     * @tparam policy Dijkstra 法で使うキュー (重みなしなら無視)
+     * @param start_node 始点
+     * @param invalid 到達不能な頂点に格納される値
+     * @return 各ノードまでの最短距離のリスト
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<Cost> distances(i32 start_node, Cost invalid) const {
+        return distances<policy>({{start_node, 0}}, invalid);
+    }
+
+    /**
+     * @brief 重みなしグラフの最短距離を方向最適化 bfs で計算する
+     * @param num_threads 並列に処理するスレッド数
+     * @attention 有向グラフのときは毎回逆向きの隣接を構築する
+     */
+    std::vector<Cost> distances(i32 start_node, Cost invalid,
+                                i32 num_threads) const {
+        static_assert(!is_weighted);
+        std::vector<i32> dist;
+        if constexpr (is_directed) {
+            auto R = rev();
+            dist = internal::directionOptimizingBfs(
+                _ofs, _to, R._ofs, R._to, {start_node}, num_threads);
+        } else {
+            dist = internal::directionOptimizingBfs(_ofs, _to, _ofs, _to,
+                                                    {start_node}, num_threads);
+        }
+        for (auto &d : dist)
+            if (d == -1)
+                d = invalid;
+        return dist;
+    }
+
+    /**
+     * @brief 多始点・打ち切りつきの最短距離
+     * @param sources {始点, 初期距離} のリスト
+     * @param invalid 到達不能な (または打ち切られた) 頂点に格納される値
+     * @param targets 空でなければ、これらの距離が全て確定した時点で打ち切る
+     * @param bound 距離が bound を超える頂点は探索しない
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<Cost>
+    distances(const std::vector<std::pair<i32, Cost>> &sources, Cost invalid,
+              const std::vector<i32> &targets = {}, Cost bound = CMAX) const {
+        ShortestPathWorkspace<is_weighted> ws;
+        distances<policy>(ws, sources, targets, bound);
+        std::vector<Cost> dist(N, invalid);
+        for (i32 v : ws.touched())
+            dist[v] = ws.dist(v);
+        return dist;
+    }
+
+    /**
+     * @brief 作業領域 ws を使い回す多始点・打ち切りつきの最短距離
+     * @return 距離が確定したノードのリスト (距離は ws.dist(v) で得る)
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    const std::vector<i32> &
+    distances(ShortestPathWorkspace<is_weighted> &ws,
+              const std::vector<std::pair<i32, Cost>> &sources,
+              const std::vector<i32> &targets = {}, Cost bound = CMAX) const {
+        ws.prepare(N);
+        shortestPathImpl<policy>(ws, sources, targets, bound);
+        return ws.touched();
+    }
+
+    /**
+     * @brief 復元付き最短経路
+     * @tparam policy Dijkstra 法で使うキュー (重みなしなら無視)
+     * @details end_node の距離が確定した時点で探索を打ち切る
+     * @attention 到達可能でないとき、空の配列で返る
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<EdgeType> shortestPath(i32 start_node, i32 end_node) const {
+        ShortestPathWorkspace<is_weighted> ws;
+        return shortestPath<policy>(start_node, end_node, ws);
+    }
+    /**
+     * @brief 作業領域 ws を使い回す復元付き最短経路
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<EdgeType>
+    shortestPath(i32 start_node, i32 end_node,
+                 ShortestPathWorkspace<is_weighted> &ws) const {
+        // 始点と終点は配列を作らずに渡す
+        const std::pair<i32, Cost> src(start_node, 0);
+        ws.prepare(N);
+        shortestPathImpl<policy>(ws, {&src, 1}, {&end_node, 1}, CMAX);
+        if (!ws.reached(end_node))
+            return {};
+        return internal::restorePath(ws, 0, start_node, end_node);
+    }
+
+    /**
+     * @brief 両方向探索による復元付き最短経路
+     * @param R 逆向きのグラフ (rev() の結果)。無向グラフなら自身
+     * @attention 到達可能でないとき、空の配列で返る
+     * @attention 負のコストの辺があってはならない
+     */
+    std::vector<EdgeType>
+    bidirectionalShortestPath(i32 start_node, i32 end_node, const CsrGraph &R,
+                              ShortestPathWorkspace<is_weighted> &ws) const {
+        ws.prepare(N);
+        return internal::bidirectionalSearch(ws, adjacency(), R.adjacency(),
+                                             start_node, end_node);
+    }
+    std::vector<EdgeType> bidirectionalShortestPath(i32 start_node,
+                                                    i32 end_node,
+                                                    const CsrGraph &R) const {
+        ShortestPathWorkspace<is_weighted> ws;
+        return bidirectionalShortestPath(start_node, end_node, R, ws);
+    }
+    /**
+     * @brief 両方向探索による復元付き最短経路
+     * @attention 有向グラフのときは毎回 rev() を構築する
+     */
+    std::vector<EdgeType> bidirectionalShortestPath(i32 start_node,
+                                                    i32 end_node) const {
+        if constexpr (is_directed) {
+            return bidirectionalShortestPath(start_node, end_node, rev());
+        } else {
+            return bidirectionalShortestPath(start_node, end_node, *this);
+        }
+    }
+
+    /**
+     * @brief 始点ごとの Dijkstra 法による全点対間最短路 O(NM log N)
+     * @param table i から j への距離を table[i * N + j] に格納する
+     * @param num_threads 並列に処理するスレッド数
+     * @details 負の辺があれば Johnson 法でコストを付け替える
+     * @return 負閉路が存在しないか (存在すれば table の中身は不定)
+     */
+    bool distancesFromAllNodesSparse(std::vector<Cost> &table, Cost invalid,
+                                     i32 num_threads = 1) const {
+        table.resize((i64)N * N);
+        return internal::allPairsDijkstra<is_weighted>(
+            N, adjacency(), table.data(), invalid, num_threads);
+    }
+
+  private:
+    // 明示的なスタックによる dfs
+    // 行きがけ・通りがけ・帰りがけの順序は Graph の再帰版と一致する
+    template <bool pre, bool in, bool post>
+    void dfsImpl(i32 start, std::vector<bool> &visited,
+                 std::vector<i32> &result) const {
+        std::vector<std::pair<i32, i32>> stk; // {ノード, 次に見る arc}
+        stk.emplace_back(start, _ofs[start]);
+        if constexpr (pre)
+            result.push_back(start);
+        while (!stk.empty()) {
+            auto &[cu, a] = stk.back();
+            if (a == _ofs[cu + 1]) {
+                if constexpr (in || post)
+                    result.push_back(cu);
+                stk.pop_back();
+                continue;
+            }
+            i32 to = _to[a++];
+            if (visited[to])
+                continue;
+            visited[to] = true;
+            if constexpr (in)
+                result.push_back(cu);
+            if constexpr (pre)
+                result.push_back(to);
+            stk.emplace_back(to, _ofs[to]);
+        }
+    }
+
+  public:
+    /**
+     * @brief 行きがけ順に dfs
+     */
+    std::vector<i32> preorder(i32 start) const {
+        std::vector<bool> visited(N, false);
+        return preorder(start, visited);
+    }
+    /**
+     * @brief visited が false のノードを行きがけ順に dfs
+     */
+    std::vector<i32> preorder(i32 start, std::vector<bool> &visited) const {
+        assert(!visited[start]);
+        std::vector<i32> result;
+        visited[start] = true;
+        dfsImpl<true, false, false>(start, visited, result);
+        return result;
+    }
+
+    /**
+     * @brief 通りがけ順に dfs
+     */
+    std::vector<i32> inorder(i32 start) const {
+        std::vector<bool> visited(N, false);
+        return inorder(start, visited);
+    }
+    /**
+     * @brief visited が false のノードを通りがけ順に dfs
+     */
+    std::vector<i32> inorder(i32 start, std::vector<bool> &visited) const {
+        assert(!visited[start]);
+        std::vector<i32> result;
+        visited[start] = true;
+        dfsImpl<false, true, false>(start, visited, result);
+        return result;
+    }
+
+    /**
+     * @brief 帰りがけ順に dfs
+     */
+    std::vector<i32> postorder(i32 start) const {
+        std::vector<bool> visited(N, false);
+        return postorder(start, visited);
+    }
+    /**
+     * @brief visited が false のノードを帰りがけ順に dfs
+     */
+    std::vector<i32> postorder(i32 start, std::vector<bool> &visited) const {
+        assert(!visited[start]);
+        std::vector<i32> result;
+        visited[start] = true;
+        dfsImpl<false, false, true>(start, visited, result);
+        return result;
+    }
+
+    /**
+     * @brief 強連結成分ごとに分解
+     * @return {縮約後のグラフ、nd_id}
+     */
+    std::tuple<CsrGraph, std::vector<i32>> scc() const {
+        std::vector<i32> nd_id(N, -1), ord;
+        ord.reserve(N);
+        std::vector<bool> used(N, false);
+
+        for (i32 i = 0; i < N; i++) {
+            if (used[i])
+                continue;
+            used[i] = true;
+            dfsImpl<false, false, true>(i, used, ord);
+        }
+
+        i32 id = 0;
+        used.assign(N, false);
+        auto R(rev());
+        std::vector<i32> comp;
+        for (auto it = ord.rbegin(); it != ord.rend(); ++it) {
+            if (used[*it])
+                continue;
+            comp.clear();
+            used[*it] = true;
+            R.template dfsImpl<true, false, false>(*it, used, comp);
+            for (auto y : comp)
+                nd_id[y] = id;
+            ++id;
+        }
+        std::vector<EdgeType> S;
+        S.reserve(E.size());
+        for (auto &e : E)
+            S.emplace_back(nd_id[e.v0], nd_id[e.v1], e.cost, e.id);
+        return {CsrGraph(id, std::move(S)), nd_id};
+    }
+
+    /**
+     * @brief 明示的なスタックによる lowlink
+     * @return {ord, low, dfs 木}
+     */
+    std::tuple<std::vector<i32>, std::vector<i32>,
+               CsrGraph<is_weighted, DIRECTED>>
+    lowlink() const {
+        static_assert(!is_directed);
+        std::vector<i32> ord(N, -1), low(N, i32MAX);
+        std::vector<EdgeType> tree;
+        tree.reserve(N);
+        // {ノード, 直前に使った辺, 次に見る arc}
+        std::vector<std::tuple<i32, i32, i32>> stk;
+        for (i32 i = 0; i < N; ++i) {
+            if (ord[i] != -1)
+                continue;
+            i32 id = 0;
+            ord[i] = low[i] = id++;
+            stk.emplace_back(i, -1, _ofs[i]);
+            while (!stk.empty()) {
+                auto &[cu, e_idx, a] = stk.back();
+                if (a == _ofs[cu + 1]) {
+                    i32 ch = cu;
+                    stk.pop_back();
+                    if (!stk.empty())
+                        chmin(low[std::get<0>(stk.back())], low[ch]);
+                    continue;
+                }
+                i32 to = _to[a], idx = _eidx[a];
+                ++a;
+                if (idx == e_idx) // 直前に使った辺を戻らない
+                    continue;
+                if (ord[to] == -1) {
+                    tree.emplace_back(cu, to, E[idx].cost, E[idx].id);
+                    ord[to] = low[to] = id++;
+                    stk.emplace_back(to, idx, _ofs[to]);
+                } else {
+                    chmin(low[cu], ord[to]);
+                }
+            }
+        }
+        return {ord, low, CsrGraph<is_weighted, DIRECTED>(N, std::move(tree))};
+    }
+
+    /**
+     * @brief グラフの橋を求める 単純連結でなくてもOK
+     */
+    std::vector<EdgeType> bridges() const {
+        static_assert(!is_directed);
+        auto [ord, low, tree] = lowlink();
+        std::vector<EdgeType> res;
+        for (auto &e : tree.getAllEdges()) {
+            if (ord[e.v0] < low[e.v1]) {
+                res.push_back(e);
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief グラフの関節点を求める 単純連結でなくてもOK
+     * @return 関節点iを消した際の連結成分の増分
+     * @attention 成分が1つのグラフの増分は-1
+     */
+    std::vector<i32> articulationPoints() const {
+        static_assert(!is_directed);
+        auto [ord, low, tree] = lowlink();
+        std::vector<i32> sep(N, 0);
+        for (i32 src = 0; src < N; ++src) {
+            if (ord[src] == 0) {
+                sep[src] = tree.degree(src) - 1;
+            } else {
+                for (i32 a = tree.arcBegin(src); a < tree.arcEnd(src); ++a) {
+                    sep[src] += (ord[src] <= low[tree.to(a)]);
+                }
+            }
+        }
+        return sep;
+    }
+
+    /**
+     * @return 最小全域森
+     */
+    CsrGraph mst() const {
+        static_assert(is_weighted && !is_directed);
+        std::vector<std::pair<Cost, i32>> idx(E.size());
+        for (i32 i = 0; i < (i32)E.size(); ++i)
+            idx[i] = {E[i].cost, i};
+        std::stable_sort(
+            idx.begin(), idx.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+
+        std::vector<EdgeType> ret;
+        ret.reserve(N);
+        UnionFind uf(N);
+        for (auto [c, i] : idx) {
+            if (uf.unite(E[i].v0, E[i].v1))
+                ret.push_back(E[i]);
+        }
+        return CsrGraph(N, std::move(ret));
+    }
+};
+
+} // namespace gandalfr
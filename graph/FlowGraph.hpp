@@ -5,11 +5,28 @@
 #include <iostream>
 #include <memory>
 #include <queue>
+#include <tuple>
+#include <vector>
 
 #include "../types.hpp"
+#include "ResidualGraph.hpp"
 
 namespace gandalfr {
 
+/**
+ * @brief 最大流のアルゴリズム
+ * @details DINIC は疎なグラフや単位容量のグラフで、PUSH_RELABEL は密なグラフ
+ * で速いことが多い
+ */
+enum class MaxFlowAlgorithm { DINIC, PUSH_RELABEL };
+
+/**
+ * @brief 最小費用流のアルゴリズム
+ * @details PRIMAL_DUAL は流量や増加路の費用の種類が少ないときに、
+ * COST_SCALING は辺が多くコストの値が大きいときに速いことが多い
+ */
+enum class MinCostFlowAlgorithm { PRIMAL_DUAL, COST_SCALING };
+
 struct FlowEdge {
   public:
     using Flow = i64;
@@ -20,7 +37,7 @@ struct FlowEdge {
 
   public:
     i32 v0, v1;
-    Cost cost;
+    Cost cost = 0;
     i32 id;
 
     FlowEdge() {}
@@ -49,6 +66,21 @@ struct FlowEdge {
         std::abort();
     }
 
+    Flow capacity() const { return cap; }
+    Flow flow() const { return cap - res; }
+    void setFlow(Flow f) {
+        assert(0 <= f && f <= cap);
+        res = cap - f;
+    }
+    /**
+     * @attention 流量が c 以下であること
+     */
+    void setCapacity(Flow c) {
+        assert(flow() <= c);
+        res += c - cap;
+        cap = c;
+    }
+
     FlowEdge rev() const {
         return {v1, v0, cap - res, cap, this->cost, this->id};
     }
@@ -99,6 +131,7 @@ class FlowGraph {
     i32 N = 0;
     std::vector<std::vector<Edge_ptr>> G;
     std::vector<Edge_ptr> E;
+    std::vector<Cost> _pot;
 
   public:
     /**
@@ -129,35 +162,28 @@ class FlowGraph {
     FlowGraph() {}
     explicit FlowGraph(i32 n) : N(n), G(n) {}
     FlowGraph(i32 n, i32 m) : N(n), G(n) { E.reserve(m); }
-    FlowGraph(const FlowGraph &other) : N(other.N), G(other.N) {
-        for (i32 i = 0; i < (i32)other.G.size(); ++i) {
-            for (const auto &e : other[i]) {
-                G[i].push_back(std::make_shared<FlowEdge>(*e));
-            }
-        }
-        for (const auto &e : other.E) {
-            E.push_back(std::make_shared<FlowEdge>(*e));
-        }
+    // G と E が同じ辺の実体を共有するように複製する
+    FlowGraph(const FlowGraph &other)
+        : N(other.N), G(other.N), _pot(other._pot) {
+        E.reserve(other.E.size());
+        for (const auto &e : other.E)
+            addEdge(*e);
     }
 
     FlowGraph(FlowGraph &&other) noexcept
-        : N(other.N), G(std::move(other.G)), E(std::move(other.E)) {
+        : N(other.N), G(std::move(other.G)), E(std::move(other.E)),
+          _pot(std::move(other._pot)) {
         other.N = 0;
     }
 
     FlowGraph &operator=(const FlowGraph &other) {
         if (this != &other) {
             N = other.N;
-            G.clear(), E.clear();
-            G.resize(other.G.size());
-            for (i32 i = 0; i < (i32)other.G.size(); ++i) {
-                for (const auto &e : other.G[i]) {
-                    G[i].push_back(std::make_shared<FlowEdge>(*e));
-                }
-            }
-            for (const auto &e : other.E) {
-                E.push_back(std::make_shared<FlowEdge>(*e));
-            }
+            G.assign(other.G.size(), {});
+            E.clear();
+            for (const auto &e : other.E)
+                addEdge(*e);
+            _pot = other._pot;
         }
         return *this;
     }
@@ -166,6 +192,7 @@ class FlowGraph {
             N = other.N;
             G = std::move(other.G);
             E = std::move(other.E);
+            _pot = std::move(other._pot);
             other.N = 0;
         }
         return *this;
@@ -239,119 +266,193 @@ class FlowGraph {
     }
 
   private:
-    Flow dinicImpl(i32 src, Flow f, const std::vector<i32> &dist, const i32 s) {
-        if (src == s)
-            return f;
-        for (auto &e : this->G[src]) {
-            i32 dst = e->dst(src);
-            if (dist[dst] != dist[src] - 1 || e->isFull(dst))
-                continue;
-            Flow tmp =
-                dinicImpl(dst, std::min<Flow>(e->residual(dst), f), dist, s);
-            if (tmp > 0) {
-                e->addFlow(dst, tmp);
-                return tmp;
-            }
-        }
-        return 0;
+    // 現在の流量を初期状態とする残余グラフを作る
+    ResidualGraph toResidual() const {
+        ResidualGraph R(N, E.size());
+        for (auto &e : E)
+            R.addEdge(e->v0, e->v1, e->capacity(), e->cost, e->flow());
+        R.build();
+        return R;
+    }
+
+    // 残余グラフの流量を各辺に書き戻す
+    void applyFlow(const ResidualGraph &R) {
+        for (i32 i = 0; i < (i32)E.size(); ++i)
+            E[i]->setFlow(R.flow(i));
     }
 
   public:
+    /**
+     * @brief Dinic 法による最大流 O(V^2 E)
+     * @details 平坦な残余グラフ上で current arc つきの非再帰 dfs を行い、
+     * 結果の流量を各辺に書き戻す
+     */
     Flow dinic(i32 s, i32 t) {
-        const i32 INVALID = std::numeric_limits<i32>::max();
+        ResidualGraph R = toResidual();
+        Flow flow = R.dinic(s, t);
+        applyFlow(R);
+        return flow;
+    }
+
+    /**
+     * @brief 全ての辺の流量を 0 に戻す O(M)
+     */
+    void resetFlow() {
+        for (auto &e : E)
+            e->setFlow(0);
+    }
+
+    /**
+     * @brief idx 番目の辺の容量を capacity に変更し、s-t フローを実行可能に保つ
+     * @details 流量が新しい容量を超える場合のみ、残余グラフ上で超過分を
+     * 流し直す (ResidualGraph::changeCapacity)。その後 dinic(s, t) を
+     * 呼べば現在の流れから最大流を求め直せる
+     * @attention 残余グラフを毎回構築するので O(M) かかる。変更を繰り返す
+     * なら ResidualGraph を直接使うこと
+     * @return s-t フローの流量の減少量 (負にならない)
+     */
+    Flow changeCapacity(i32 idx, Flow capacity, i32 s, i32 t) {
+        auto &e = E[idx];
+        if (e->flow() <= capacity) {
+            e->setCapacity(capacity);
+            return 0;
+        }
+        ResidualGraph R = toResidual();
+        Flow dec = R.changeCapacity(idx, capacity, s, t);
+        e->setFlow(0);
+        e->setCapacity(capacity);
+        applyFlow(R);
+        return dec;
+    }
+
+    /**
+     * @brief 最大流
+     * @param algo 使うアルゴリズム
+     * @details 現在の流量から続けて流し、結果の流量を各辺に書き戻す
+     * @return 追加で流れた量
+     */
+    Flow maxFlow(i32 s, i32 t,
+                 MaxFlowAlgorithm algo = MaxFlowAlgorithm::DINIC) {
+        ResidualGraph R = toResidual();
         Flow flow = 0;
-        while (true) {
-            std::vector<i32> dist(this->N, INVALID);
-            dist[s] = 0;
-            std::queue<i32> q;
-            q.push(s);
-            while (!q.empty()) {
-                i32 src = q.front();
-                q.pop();
-                for (auto &e : this->G[src]) {
-                    i32 dst = e->dst(src);
-                    if (dist[dst] != INVALID || e->isFull(src))
-                        continue;
-                    dist[dst] = dist[src] + 1;
-                    q.push(dst);
-                }
-            }
-            if (dist[t] == INVALID)
-                break;
+        switch (algo) {
+        case MaxFlowAlgorithm::PUSH_RELABEL:
+            flow = R.pushRelabel(s, t);
+            break;
+        default:
+            flow = R.dinic(s, t);
+        }
+        applyFlow(R);
+        return flow;
+    }
 
-            while (true) {
-                Flow inc =
-                    dinicImpl(t, std::numeric_limits<Flow>::max(), dist, s);
-                if (inc == 0)
-                    break;
-                flow += inc;
+    /**
+     * @brief s-t 最小カット
+     * @details 現在の流量から続けて最大流を流し、残余グラフで s から
+     * 到達できるノードを s 側とする (s 側が極小のカット)。流量は各辺に
+     * 書き戻される
+     * @return {カットの容量, s 側なら true, s 側から t 側へ向かう辺の番号}
+     */
+    std::tuple<Flow, std::vector<bool>, std::vector<i32>>
+    minCut(i32 s, i32 t,
+           MaxFlowAlgorithm algo = MaxFlowAlgorithm::DINIC) {
+        ResidualGraph R = toResidual();
+        if (algo == MaxFlowAlgorithm::PUSH_RELABEL)
+            R.pushRelabel(s, t);
+        else
+            R.dinic(s, t);
+        applyFlow(R);
+        std::vector<bool> side = R.reachable(s);
+        Flow value = 0;
+        std::vector<i32> cut;
+        for (i32 i = 0; i < (i32)E.size(); ++i) {
+            if (side[E[i]->v0] && !side[E[i]->v1]) {
+                value += E[i]->capacity();
+                cut.push_back(i);
             }
         }
-        return flow;
+        return {value, side, cut};
     }
 
     /**
-     * @brief 最小費用流 O(FEV)
+     * @brief 最小費用流で s から t へ F だけ流す
+     * @details ResidualGraph::minCostSlope による
+     * @return 流量 F を流すときの最小コスト。F だけ流せないなら -1
+     * (流せるだけ流した状態になる)
      */
     Cost primalDual(i32 s, i32 t, Flow F) {
-        const Cost INVALID = std::numeric_limits<Cost>::max();
-        Cost cst = 0;
-        std::vector<i32> prev_path;
-        std::vector<Cost> min_cost;
-        while (F) {
-            // コストを重みとした残余グラフ上で最短路を計算
-            prev_path.assign(this->N, -1);
-            min_cost.assign(this->N, INVALID);
-            min_cost[s] = 0;
-            for (i32 i = 0; i < this->N; ++i) {
-                bool changed = false;
-                for (u32 j = 0; j < this->E.size(); ++j) {
-                    auto &e = this->E[j];
-                    i32 src = e->v0, dst = e->v1;
-                    for (i32 k = 0; k < 2; ++k) {
-                        if (min_cost[src] != INVALID && !e->isFull(src)) {
-                            Cost alt = min_cost[src] + e->getCost(src);
-                            if (min_cost[dst] > alt) {
-                                min_cost[dst] = alt;
-                                prev_path[dst] = j;
-                                changed = true;
-                            }
-                        }
-                        std::swap(src, dst);
-                    }
-                }
-                if (!changed)
-                    break;
-            }
-            if (min_cost[t] == INVALID)
-                return -1;
-
-            // 流量を計算
-            Flow f = F;
-            Cost sum = 0;
-            i32 cur = t;
-            while (cur != s) {
-                auto &e = this->E[prev_path[cur]];
-                i32 src = e->dst(cur);
-                f = std::min(f, e->residual(src));
-                cur = src;
-            }
+        auto slope = minCostSlope(s, t, F);
+        if (slope.back().first < F)
+            return -1;
+        return slope.back().second;
+    }
 
-            // グラフとコストの更新
-            cur = t;
-            while (cur != s) {
-                auto &e = this->E[prev_path[cur]];
-                i32 src = e->dst(cur);
-                e->addFlow(src, f);
-                sum += e->getCost(src);
-                cur = src;
-            }
-            F -= f;
-            cst += f * sum;
-        }
-        return cst;
+    /**
+     * @brief 最小費用流で s から t へ F だけ流す
+     * @param algo 使うアルゴリズム。COST_SCALING なら、最大流で F だけ
+     * 流してから最小費用循環流で改善する
+     * @return 流量 F を流すときの最小コスト。F だけ流せないなら -1
+     */
+    Cost minCostFlow(i32 s, i32 t, Flow F,
+                     MinCostFlowAlgorithm algo =
+                         MinCostFlowAlgorithm::PRIMAL_DUAL) {
+        if (algo == MinCostFlowAlgorithm::PRIMAL_DUAL)
+            return primalDual(s, t, F);
+        Cost before = totalCost();
+        ResidualGraph R = toResidual();
+        Flow flow = R.dinic(s, t, F);
+        R.minCostCirculation();
+        applyFlow(R);
+        return flow < F ? -1 : totalCost() - before;
     }
 
+    /**
+     * @brief コストスケーリング法で、各ノードの流量保存を保ったまま
+     * 総コストを最小化する
+     * @details 全て流量 0 から呼べば最小費用循環流になる
+     * @return 総コストの変化量
+     */
+    Cost minCostCirculation() {
+        Cost before = totalCost();
+        ResidualGraph R = toResidual();
+        R.minCostCirculation();
+        applyFlow(R);
+        return totalCost() - before;
+    }
+
+    /**
+     * @return 各辺の (コスト) * (流量) の総和
+     */
+    Cost totalCost() const {
+        Cost ret = 0;
+        for (auto &e : E)
+            ret += e->cost * e->flow();
+        return ret;
+    }
+
+    /**
+     * @brief 最小費用流で s から t へ最大 F だけ流す
+     * @details 増加路の費用ごとに Dijkstra 法を 1 回行い、同じ費用の増加路
+     * にはまとめて流す。流量 f (<= F) のときの最小コストは、返り値の折れ線
+     * の上で線形補間して得られる
+     * @return 折れ線の頂点 {流量, コスト} のリスト
+     */
+    std::vector<std::pair<Flow, Cost>>
+    minCostSlope(i32 s, i32 t, Flow F = std::numeric_limits<Flow>::max()) {
+        ResidualGraph R = toResidual();
+        auto slope = R.minCostSlope(s, t, F);
+        _pot = R.potentials();
+        applyFlow(R);
+        return slope;
+    }
+
+    /**
+     * @return 直前の minCostSlope (primalDual) で求めたポテンシャル
+     * @details 残余グラフの任意の辺 u -> v について
+     * cost + p[u] - p[v] >= 0 が成り立つ
+     */
+    const std::vector<Cost> &potentials() const { return _pot; }
+
     void print() const {
         std::cout << this->N << " " << this->E.size() << std::endl;
         for (auto &e : this->E)
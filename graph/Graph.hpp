@@ -5,12 +5,15 @@
 #include <iostream>
 #include <memory>
 #include <queue>
+#include <span>
 #include <utility>
 #include <vector>
 #include <unordered_set>
 
+#include "../data_structure/ConcurrentUnionFind.hpp"
 #include "../data_structure/UnionFind.hpp"
 #include "../math/Matrix.hpp"
+#include "../other/parallel.hpp"
 #include "../types.hpp"
 
 #define GRAPH_TEMPLATE template <bool is_weighted, bool is_directed>
@@ -26,6 +29,23 @@ constexpr bool UNWEIGHTED = false;
 constexpr bool DIRECTED = true;
 constexpr bool UNDIRECTED = false;
 
+/**
+ * @brief 重みつき最短路で使うキュー
+ * @details BINARY: 二分ヒープ, RADIX: radix heap, BUCKET: Dial のバケット,
+ * AUTO: 辺のコストを見て選ぶ (負辺があれば BINARY)
+ * @attention RADIX, BUCKET は非負整数コストを要請
+ */
+enum class HeapPolicy { BINARY, RADIX, BUCKET, AUTO };
+
+/**
+ * @brief 最小全域森のアルゴリズム
+ * @details FILTER_KRUSKAL は辺が多いとき、BORUVKA は複数スレッドで速い。
+ * どれも (コスト, 辺の番号) の辞書順で比べるので、同じ森を返す
+ */
+enum class MstAlgorithm { KRUSKAL, FILTER_KRUSKAL, BORUVKA };
+
+template <bool is_weighted> class ShortestPathWorkspace;
+
 template <bool is_weighted> struct Edge {
     using Cost = std::conditional_t<is_weighted, i64, i32>;
 
@@ -88,6 +108,8 @@ template <bool is_weighted, bool is_directed> class Graph {
     std::vector<std::vector<EdgePtr>> G;
     std::vector<EdgePtr> E;
     Cost cost_sum = 0;
+    // 辺のコストの最小値と最大値 (0 も含めた範囲)。キューの選択に使う
+    Cost cost_min = 0, cost_max = 0;
     static constexpr Cost CMAX = std::numeric_limits<Cost>::max(),
                           CMIN = std::numeric_limits<Cost>::lowest();
 
@@ -96,7 +118,8 @@ template <bool is_weighted, bool is_directed> class Graph {
     explicit Graph(i32 n) : N(n), G(n) {}
     Graph(i32 n, i32 m) : N(n), G(n) { E.reserve(m); }
     Graph(const Graph &other)
-        : N(other.N), G(other.N), cost_sum(other.cost_sum) {
+        : N(other.N), G(other.N), cost_sum(other.cost_sum),
+          cost_min(other.cost_min), cost_max(other.cost_max) {
         for (i32 i = 0; i < (i32)other.G.size(); ++i) {
             for (const auto &e : other[i]) {
                 G[i].push_back(std::make_shared<EdgeType>(*e));
@@ -108,9 +131,10 @@ template <bool is_weighted, bool is_directed> class Graph {
     }
     Graph(Graph &&other) noexcept
         : N(other.N), G(std::move(other.G)), E(std::move(other.E)),
-          cost_sum(other.cost_sum) {
+          cost_sum(other.cost_sum), cost_min(other.cost_min),
+          cost_max(other.cost_max) {
         other.N = 0;
-        other.cost_sum = 0;
+        other.cost_sum = other.cost_min = other.cost_max = 0;
     }
 
     Graph &operator=(const Graph &other) {
@@ -119,6 +143,7 @@ template <bool is_weighted, bool is_directed> class Graph {
             G.clear(), E.clear();
             G.resize(other.G.size());
             cost_sum = other.cost_sum;
+            cost_min = other.cost_min, cost_max = other.cost_max;
             for (i32 i = 0; i < (i32)other.G.size(); ++i) {
                 for (const auto &e : other.G[i]) {
                     G[i].push_back(std::make_shared<EdgeType>(*e));
@@ -136,8 +161,9 @@ template <bool is_weighted, bool is_directed> class Graph {
             G = std::move(other.G);
             E = std::move(other.E);
             cost_sum = other.cost_sum;
+            cost_min = other.cost_min, cost_max = other.cost_max;
             other.N = 0;
-            other.cost_sum = 0;
+            other.cost_sum = other.cost_min = other.cost_max = 0;
         }
         return *this;
     }
@@ -200,6 +226,47 @@ template <bool is_weighted, bool is_directed> class Graph {
             }
         }
         cost_sum += e.cost;
+        chmin(cost_min, e.cost);
+        chmax(cost_max, e.cost);
+    }
+
+    /**
+     * @brief 辺をまとめて追加する
+     * @details 辺の実体は 1 回の確保で連続領域に置き、各ノードの隣接リストは
+     * 次数を数えてから確保する
+     * @attention 渡した辺の id は保持される
+     */
+    void addEdges(std::span<const EdgeType> edges) {
+        if (edges.empty())
+            return;
+        std::vector<i32> deg(N, 0);
+        for (auto &e : edges) {
+            ++deg[e.v0];
+            if constexpr (!is_directed) {
+                if (e.v0 != e.v1)
+                    ++deg[e.v1];
+            }
+        }
+        for (i32 i = 0; i < N; ++i)
+            G[i].reserve(G[i].size() + deg[i]);
+        E.reserve(E.size() + edges.size());
+
+        auto block = std::make_shared<EdgeType[]>(edges.size());
+        for (u32 i = 0; i < edges.size(); ++i) {
+            block[i] = edges[i];
+            // block と所有権を共有するので辺ごとの確保は起きない
+            EdgePtr ptr(block, &block[i]);
+            E.push_back(ptr);
+            G[edges[i].v0].push_back(ptr);
+            if constexpr (!is_directed) {
+                if (edges[i].v0 != edges[i].v1) {
+                    G[edges[i].v1].push_back(std::move(ptr));
+                }
+            }
+            cost_sum += edges[i].cost;
+            chmin(cost_min, edges[i].cost);
+            chmax(cost_max, edges[i].cost);
+        }
     }
 
     /**
@@ -251,52 +318,162 @@ template <bool is_weighted, bool is_directed> class Graph {
         return ret;
     }
 
-    UnionFind buildUnionFind() const {
+    /**
+     * @param num_threads 2 以上なら、辺を ConcurrentUnionFind で並列に
+     * 併合してから UnionFind に移す
+     * @return 辺で結ばれたノードをまとめた UnionFind
+     */
+    UnionFind buildUnionFind(i32 num_threads = 1) const {
         UnionFind uf(N);
-        for (auto &e : E) {
-            uf.unite(e->v0, e->v1);
+        if (num_threads <= 1) {
+            for (auto &e : E) {
+                uf.unite(e->v0, e->v1);
+            }
+            return uf;
         }
+        ConcurrentUnionFind cuf(N);
+        const i32 M = E.size(), K = std::min(M, num_threads * 8);
+        parallelFor(K, num_threads, [&](i32 k) {
+            for (i32 i = (i64)M * k / K; i < (i64)M * (k + 1) / K; ++i)
+                cuf.unite(E[i]->v0, E[i]->v1);
+        });
+        for (i32 v = 0; v < N; ++v)
+            uf.unite(v, cuf.leader(v));
         return uf;
     }
 
   private:
-    std::vector<EdgePtr> dijkstraImpl(std::vector<Cost> &dist,
-                                      i32 start_node) const;
-    std::vector<EdgePtr> bfsImpl(std::vector<i32> &dist, i32 start_node) const;
+    HeapPolicy selectHeap(std::span<const std::pair<i32, Cost>> sources) const;
+    template <HeapPolicy policy>
+    void shortestPathImpl(ShortestPathWorkspace<is_weighted> &ws,
+                          std::span<const std::pair<i32, Cost>> sources,
+                          std::span<const i32> targets, Cost bound) const;
 
   public:
     /**
      * @brief 最短距離を計算する
+     * @tparam policy Dijkstra 法で使うキュー (重みなしなら無視)
      * @param start_node 始点
      * @param invalid 到達不能な頂点に格納される値
      * @return 各ノードまでの最短距離のリスト
      * @note "shortestPath.hpp" をインクルードすること
      */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
     std::vector<Cost> distances(i32 start_node, Cost invalid) const;
+    /**
+     * @brief 重みなしグラフの最短距離を方向最適化 bfs で計算する
+     * @param num_threads 並列に処理するスレッド数
+     * @details 直径の小さいグラフでは、フロンティアが大きい層を未訪問の頂点
+     * 側から探索することで調べる辺の本数を減らせる
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    std::vector<Cost> distances(i32 start_node, Cost invalid,
+                                i32 num_threads) const;
+
+    /**
+     * @brief 多始点・打ち切りつきの最短距離
+     * @tparam policy Dijkstra 法で使うキュー (重みなしなら無視)
+     * @param sources {始点, 初期距離} のリスト
+     * @param invalid 到達不能な (または打ち切られた) 頂点に格納される値
+     * @param targets 空でなければ、これらの距離が全て確定した時点で打ち切る
+     * @param bound 距離が bound を超える頂点は探索しない
+     * @attention 打ち切った場合、距離が確定していない頂点は invalid になる
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<Cost>
+    distances(const std::vector<std::pair<i32, Cost>> &sources, Cost invalid,
+              const std::vector<i32> &targets = {}, Cost bound = CMAX) const;
+
+    /**
+     * @brief 作業領域 ws を使い回す多始点・打ち切りつきの最短距離
+     * @details ws の初期化はならし O(1) で、結果は ws.dist(v) で得る
+     * @return 距離が確定したノードのリスト
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    const std::vector<i32> &
+    distances(ShortestPathWorkspace<is_weighted> &ws,
+              const std::vector<std::pair<i32, Cost>> &sources,
+              const std::vector<i32> &targets = {}, Cost bound = CMAX) const;
 
     /**
      * @brief 復元付き最短経路
+     * @tparam policy Dijkstra 法で使うキュー (重みなしなら無視)
+     * @details end_node の距離が確定した時点で探索を打ち切る
      * @attention 到達可能でないとき、空の配列で返る
      * @attention 負閉路があるとき正しい動作を保証しない
      * @note "shortestPath.hpp" をインクルードすること
      */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
     std::vector<EdgeType> shortestPath(i32 start_node, i32 end_node) const;
+    /**
+     * @brief 作業領域 ws を使い回す復元付き最短経路
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    template <HeapPolicy policy = HeapPolicy::BINARY>
+    std::vector<EdgeType>
+    shortestPath(i32 start_node, i32 end_node,
+                 ShortestPathWorkspace<is_weighted> &ws) const;
+
+    /**
+     * @brief 両方向探索による復元付き最短経路
+     * @param R 逆向きのグラフ (rev() の結果)。無向グラフなら自身
+     * @attention 到達可能でないとき、空の配列で返る
+     * @attention 負のコストの辺があってはならない
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    std::vector<EdgeType> bidirectionalShortestPath(i32 start_node,
+                                                    i32 end_node,
+                                                    const Graph &R) const;
+    /**
+     * @brief 作業領域 ws を使い回す両方向探索
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    std::vector<EdgeType>
+    bidirectionalShortestPath(i32 start_node, i32 end_node, const Graph &R,
+                              ShortestPathWorkspace<is_weighted> &ws) const;
+    /**
+     * @brief 両方向探索による復元付き最短経路
+     * @attention 有向グラフのときは毎回 rev() を構築するので、
+     * 繰り返し呼ぶなら R を渡す方を使うこと
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    std::vector<EdgeType> bidirectionalShortestPath(i32 start_node,
+                                                    i32 end_node) const;
 
     /**
      * @brief ワーシャルフロイド法 O(N^3)
+     * @param num_threads 並列に処理するスレッド数
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    Matrix<Cost> distancesFromAllNodes(Cost invalid,
+                                       i32 num_threads = 1) const;
+    /**
+     * @brief ワーシャルフロイド法 O(N^3)
+     * @param table i から j への距離を table[i * N + j] に格納する
+     * @details キャッシュに乗るブロック単位で更新する
+     * @attention 経路長の絶対値は Cost の最大値の 1/8 未満であること
+     * @note "shortestPath.hpp" をインクルードすること
+     */
+    void distancesFromAllNodes(std::vector<Cost> &table, Cost invalid,
+                               i32 num_threads = 1) const;
+    /**
+     * @brief 始点ごとの Dijkstra 法による全点対間最短路 O(NM log N)
+     * @param table i から j への距離を table[i * N + j] に格納する
+     * @param num_threads 並列に処理するスレッド数
+     * @details 疎なグラフではワーシャルフロイド法より速い。負の辺があれば
+     * Johnson 法でコストを付け替える (前処理に O(NM))
+     * @return 負閉路が存在しないか (存在すれば table の中身は不定)
      * @note "shortestPath.hpp" をインクルードすること
      */
-    Matrix<Cost> distancesFromAllNodes(Cost invalid) const;
+    bool distancesFromAllNodesSparse(std::vector<Cost> &table, Cost invalid,
+                                     i32 num_threads = 1) const;
 
   private:
-    void preorderImpl(i32 cu, std::vector<bool> &visited,
-                      std::vector<i32> &result) const;
-
-    void inorderImpl(i32 cu, std::vector<bool> &visited,
-                     std::vector<i32> &result) const;
-
-    void postorderImpl(i32 cu, std::vector<bool> &visited,
-                       std::vector<i32> &result) const;
+    template <bool pre, bool in, bool post>
+    void dfsImpl(i32 start, std::vector<bool> &visited,
+                 std::vector<i32> &result) const;
 
   public:
     /**
@@ -333,21 +510,47 @@ template <bool is_weighted, bool is_directed> class Graph {
     std::vector<i32> postorder(i32 start, std::vector<bool> &visited) const;
 
     /**
-     * @return 最小全域森
+     * @param algo 使うアルゴリズム
+     * @param num_threads BORUVKA で使うスレッド数
+     * @return 最小全域森 (辺はコストの昇順、同じコストなら番号順)
+     * @note "mst.hpp" をインクルードすること
+     */
+    Graph mst(MstAlgorithm algo = MstAlgorithm::KRUSKAL,
+              i32 num_threads = 1) const;
+
+    /**
+     * @brief Gomory-Hu 木 (辺の容量はコスト、重みなしなら 1) O(N) 回の最大流
+     * @details Gusfield の方法による。num_threads 本のスレッドで残余グラフの
+     * 複製を持ち、続くノードのカットを先読みする。結果はスレッド数によらない
+     * @return 2 ノード間の最小カットの値が、木の上のパスの辺の最小値に
+     * 等しい木
+     * @note "gomoryHu.hpp" をインクルードすること
      */
-    Graph mst() const;
+    Graph<WEIGHTED, UNDIRECTED> gomoryHuTree(i32 num_threads = 1) const;
 
     /**
      * @return 二部グラフかどうか
      */
     bool isBipartite() const;
 
+    /**
+     * @brief 二部グラフの最大マッチングと最小頂点被覆 (Hopcroft-Karp 法)
+     * @param dense 隣接行列をビット列で持つ版を使うか (密なグラフ向け)
+     * @details 辺の向きは無視する
+     * @return {各ノードの相手 (いなければ -1), 最小頂点被覆に含まれるか}
+     * @attention 二部グラフであること
+     * @note "BipartiteMatching.hpp" をインクルードすること
+     */
+    std::tuple<std::vector<i32>, std::vector<bool>>
+    bipartiteMatching(bool dense = false) const;
+
     /**
      * @brief 連結成分ごとに分解
+     * @param num_threads 成分を求める際に使うスレッド数
      * @return {分解後のグラフ、grp_id, nd_id}
      */
     std::tuple<std::vector<Graph>, std::vector<i32>, std::vector<i32>>
-    discomponent() const;
+    discomponent(i32 num_threads = 1) const;
 
     /**
      * @brief 強連結成分ごとに分解
@@ -356,8 +559,7 @@ template <bool is_weighted, bool is_directed> class Graph {
     std::tuple<Graph, std::vector<i32>> scc() const;
 
   private:
-    void lowlinkImpl(i32 cu, i32 e_id, i32 &id, std::vector<i32> &ord,
-                     std::vector<i32> &low,
+    void lowlinkImpl(i32 start, std::vector<i32> &ord, std::vector<i32> &low,
                      Graph<is_weighted, DIRECTED> &tree) const;
 
     std::tuple<std::vector<i32>, std::vector<i32>, Graph<is_weighted, DIRECTED>>
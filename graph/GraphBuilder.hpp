@@ -0,0 +1,111 @@
+#pragma once
+#include <istream>
+#include <span>
+#include <vector>
+
+#include "CsrGraph.hpp"
+#include "Graph.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief 辺を連続領域に溜めておき、まとめて Graph / CsrGraph を構築する
+ * @details addEdge を繰り返すのと違い、辺ごとのヒープ確保が起きない
+ */
+template <bool is_weighted, bool is_directed> class GraphBuilder {
+  public:
+    using EdgeType = Edge<is_weighted>;
+    using Cost = typename EdgeType::Cost;
+
+  private:
+    i32 N = 0;
+    std::vector<EdgeType> E;
+
+  public:
+    GraphBuilder() = default;
+    explicit GraphBuilder(i32 n) : N(n) {}
+    GraphBuilder(i32 n, i32 m) : N(n) { E.reserve(m); }
+
+    void resize(i32 n) {
+        assert(n >= N);
+        N = n;
+    }
+
+    void reserve(i32 m) { E.reserve(m); }
+
+    i32 numNodes() const { return N; }
+    i32 numEdges() const { return E.size(); }
+
+    /**
+     * @attention 渡した辺の id は保持される
+     */
+    void addEdge(const EdgeType &e) { E.push_back(e); }
+
+    /**
+     * @attention 辺の id は、(現在の辺の本数)番目 が振られる
+     */
+    void addEdge(i32 from, i32 to, Cost cost) {
+        static_assert(is_weighted);
+        E.emplace_back(from, to, cost, (i32)E.size());
+    }
+
+    /**
+     * @attention 辺の id は、(現在の辺の本数)番目 が振られる
+     */
+    void addEdge(i32 from, i32 to) {
+        static_assert(!is_weighted);
+        E.emplace_back(from, to, (i32)E.size());
+    }
+
+    /**
+     * @brief 辺をまとめて追加する
+     * @attention 渡した辺の id は保持される
+     */
+    void addEdges(std::span<const EdgeType> edges) {
+        E.insert(E.end(), edges.begin(), edges.end());
+    }
+
+    /**
+     * @brief "from to (cost)" 形式の辺を m 本読み込む
+     * @param offset 入力のノード番号から引く値 (1-indexed なら 1)
+     * @attention 辺の id は、(現在の辺の本数)番目 が振られる
+     */
+    void readEdges(std::istream &is, i32 m, i32 offset = 0) {
+        E.reserve(E.size() + m);
+        for (i32 i = 0; i < m; ++i) {
+            i32 a, b;
+            is >> a >> b;
+            if constexpr (is_weighted) {
+                Cost c;
+                is >> c;
+                E.emplace_back(a - offset, b - offset, c, (i32)E.size());
+            } else {
+                E.emplace_back(a - offset, b - offset, (i32)E.size());
+            }
+        }
+    }
+
+    const std::vector<EdgeType> &getAllEdges() const { return E; }
+
+    /**
+     * @brief Graph を構築 O(N+M)
+     * @details 辺の実体は 1 回の確保でまとめて置かれる
+     */
+    Graph<is_weighted, is_directed> build() const {
+        Graph<is_weighted, is_directed> ret(N, E.size());
+        ret.addEdges(E);
+        return ret;
+    }
+
+    /**
+     * @brief CsrGraph を構築 O(N+M)
+     * @attention 溜めた辺はムーブされ、builder は空になる
+     */
+    CsrGraph<is_weighted, is_directed> buildCsr() {
+        CsrGraph<is_weighted, is_directed> ret(N, std::move(E));
+        E.clear();
+        return ret;
+    }
+};
+
+} // namespace gandalfr
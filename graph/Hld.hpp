@@ -1,4 +1,6 @@
 #pragma once
+#include <array>
+#include <cassert>
 
 #include "Graph.hpp"
 
@@ -7,39 +9,76 @@ namespace gandalfr {
 GRAPH_TEMPLATE
 class Hld {
   private:
+    using Cost = GRAPH_COST_TYPE;
+
     GRAPH_TYPE _G;
     std::vector<i32> _sz, _in, _out, _head, _par;
+    std::vector<i32> _dep, _ord; // 根からの辺の数, _ord[_in[v]] = v
+    std::vector<Cost> _dist;     // 根からの距離
     i32 t = 0;
 
-    void dfsSz(i32 v, i32 p = -1) {
-        _par[v] = p;
-        for (auto &e : _G.G[v]) {
+    // 部分木のサイズを求め、各ノードの先頭の辺を重い子への辺にする
+    // (子がいれば、先頭が親への辺になることはない)
+    void dfsSz(i32 root) {
+        std::vector<std::pair<i32, u32>> stk; // {ノード, 次に見る辺}
+        _par[root] = -1;
+        stk.emplace_back(root, 0);
+        while (!stk.empty()) {
+            auto &[v, i] = stk.back();
+            auto &adj = _G.G[v];
+            if (i > 0) {
+                // 直前に見た辺の先が子なら、その部分木は処理済み
+                i32 u = adj[i - 1]->dst(v);
+                if (u != _par[v]) {
+                    _sz[v] += _sz[u];
+                    i32 h = adj[0]->dst(v);
+                    if (h == _par[v] || _sz[u] > _sz[h])
+                        std::swap(adj[i - 1], adj[0]);
+                }
+            }
+            if (i == adj.size()) {
+                stk.pop_back();
+                continue;
+            }
+            auto &e = adj[i++];
             i32 u = e->dst(v);
-            if (u == p)
+            if (u == _par[v])
                 continue;
-            dfsSz(u, v);
-            _sz[v] += _sz[u];
-            if (_sz[u] > _sz[_G[v][0]->dst(v)])
-                std::swap(e, _G.G[v][0]);
+            _par[u] = v;
+            _dep[u] = _dep[v] + 1;
+            _dist[u] = _dist[v] + e->cost;
+            stk.emplace_back(u, 0);
         }
     }
 
-    void dfsHld(i32 v, i32 p = -1) {
-        _in[v] = t++;
-        for (auto &e : _G[v]) {
-            i32 u = e->dst(v);
-            if (u == p)
+    // 重い子から順に辿って行きがけ順の番号を振る
+    void dfsHld(i32 root) {
+        std::vector<std::pair<i32, u32>> stk;
+        _ord[t] = root;
+        _in[root] = t++;
+        stk.emplace_back(root, 0);
+        while (!stk.empty()) {
+            auto &[v, i] = stk.back();
+            if (i == _G[v].size()) {
+                _out[v] = t;
+                stk.pop_back();
+                continue;
+            }
+            i32 u = _G[v][i++]->dst(v);
+            if (u == _par[v])
                 continue;
             _head[u] = (u == _G[v][0]->dst(v) ? _head[v] : u);
-            dfsHld(u, v);
+            _ord[t] = u;
+            _in[u] = t++;
+            stk.emplace_back(u, 0);
         }
-        _out[v] = t;
     }
 
   public:
     Hld(const GRAPH_TYPE &G, i32 root = 0)
         : _G(G), _sz(G.numNodes(), 1), _in(G.numNodes()), _out(G.numNodes()),
-          _head(G.numNodes()), _par(G.numNodes()) {
+          _head(G.numNodes()), _par(G.numNodes()), _dep(G.numNodes(), 0),
+          _ord(G.numNodes()), _dist(G.numNodes(), 0) {
         _head[root] = root;
         dfsSz(root);
         dfsHld(root);
@@ -66,5 +105,96 @@ class Hld {
         }
         return intervals;
     }
+
+    /**
+     * @brief u から v へのパスを HLD 順の区間に分け、パスの順に
+     * f(l, r, reversed) を呼ぶ
+     * @param edge true なら辺の区間を訪れる。辺は子の側の頂点の位置 in
+     * に対応させ、LCA の位置は含まない。false なら頂点の区間を訪れる
+     * @details reversed が true の区間はパスの上で r - 1 から l の順に並ぶ。
+     * 非可換な演算では、その区間の積を逆順で取ればよい。区間は
+     * スタック上の配列に溜めるので、ヒープ確保は起きない
+     */
+    template <class F> void path(i32 u, i32 v, bool edge, F &&f) const {
+        // v 側の区間は下る順に訪れるので、後で逆順に呼ぶ
+        std::array<std::pair<i32, i32>, 64> down;
+        i32 nd = 0;
+        while (_head[u] != _head[v]) {
+            if (_in[_head[u]] > _in[_head[v]]) {
+                f(_in[_head[u]], _in[u] + 1, true);
+                u = _par[_head[u]];
+            } else {
+                assert(nd < (i32)down.size());
+                down[nd++] = {_in[_head[v]], _in[v] + 1};
+                v = _par[_head[v]];
+            }
+        }
+        if (_in[u] > _in[v]) {
+            f(_in[v] + edge, _in[u] + 1, true);
+        } else if (_in[u] + edge < _in[v] + 1) {
+            f(_in[u] + edge, _in[v] + 1, false);
+        }
+        while (nd > 0) {
+            --nd;
+            f(down[nd].first, down[nd].second, false);
+        }
+    }
+
+    /**
+     * @return 根からの辺の数
+     */
+    i32 depth(i32 v) const { return _dep[v]; }
+
+    /**
+     * @return 親 (根なら -1)
+     */
+    i32 parent(i32 v) const { return _par[v]; }
+
+    /**
+     * @brief v から k 本根の側に上ったノード O(log N)
+     * @return k が v の深さを超えるなら -1
+     */
+    i32 levelAncestor(i32 v, i32 k) const {
+        if (k > _dep[v])
+            return -1;
+        while (_dep[v] - _dep[_head[v]] < k) {
+            k -= _dep[v] - _dep[_head[v]] + 1;
+            v = _par[_head[v]];
+        }
+        return _ord[_in[v] - k];
+    }
+
+    /**
+     * @brief 最小共通祖先 O(log N)
+     */
+    i32 lca(i32 u, i32 v) const {
+        while (_head[u] != _head[v]) {
+            if (_in[_head[u]] > _in[_head[v]])
+                std::swap(u, v);
+            v = _par[_head[v]];
+        }
+        return (_in[u] < _in[v] ? u : v);
+    }
+
+    /**
+     * @brief 2 ノード間の距離 (重みなしなら辺の数) O(log N)
+     */
+    Cost distance(i32 u, i32 v) const {
+        return _dist[u] + _dist[v] - 2 * _dist[lca(u, v)];
+    }
+
+    /**
+     * @brief u から v へのパス上で、u から k 本進んだノード O(log N)
+     * @return k がパスの辺の数を超えるなら -1
+     */
+    i32 kthOnPath(i32 u, i32 v, i32 k) const {
+        i32 w = lca(u, v);
+        i32 du = _dep[u] - _dep[w], dv = _dep[v] - _dep[w];
+        if (k <= du)
+            return levelAncestor(u, k);
+        if (k <= du + dv)
+            return levelAncestor(v, du + dv - k);
+        return -1;
+    }
 };
 } // namespace gandalfr
@@ -1,56 +1,178 @@
 #pragma once
-#include "../data_structure/SparseTable.hpp"
-#include "dfs.hpp"
-#include "shortestPath.hpp"
+#include "../other/parallel.hpp"
+#include "Graph.hpp"
 #include <algorithm>
+#include <bit>
 
 namespace gandalfr {
 
 /**
  * @brief 無向単純木の最小共通祖先を求めるクラス
+ * @details 行きがけ順を ord, その逆を tin として、u != v (tin[u] < tin[v])
+ * の LCA は、ord(tin[u], tin[v]] の各頂点の親の tin の最小値を取る頂点に
+ * なる。この N 要素の列の区間最小値を、32 要素のブロックごとの sparse
+ * table と、ブロック内の単調スタックをビット列で持つことで O(1) で求める。
+ * 構築は非再帰 dfs 1 回で O(N)、メモリも O(N)
  */
 template <bool is_weighted> class Lca {
   private:
     using EdgeType = Edge<is_weighted>;
     using Cost = typename EdgeType::Cost;
-    using Pair = std::pair<i32, i32>;
     using GraphType = Graph<is_weighted, UNDIRECTED>;
+    static constexpr i32 B = 32;
 
-    static Pair min(Pair a, Pair b) { return a.first < b.first ? a : b; }
-    static constexpr Pair e() { return {0, 0}; }
-
-    std::vector<i32> idx;
-    std::vector<Pair> depth;
-    SparseTable<Pair, Lca::min, Lca::e> sps;
+    i32 nb = 0; // ブロックの数
+    std::vector<i32> ord, tin;
+    std::vector<i32> val;  // val[i] := tin[ord[i] の親] (根は 0)
+    std::vector<u32> mask; // ブロック内で i までの区間最小値の候補の位置
+    // table[k * nb + b] := ブロック [b, b + 2^k) の最小値
+    std::vector<i32> table;
     std::vector<Cost> dist;
 
+    // val[l, r] の最小値 (l, r は同じブロック)
+    i32 inBlock(i32 l, i32 r) const {
+        u32 m = mask[r] & (~0u << (l % B));
+        return val[r / B * B + std::countr_zero(m)];
+    }
+
+    // val[l, r] の最小値
+    i32 rangeMin(i32 l, i32 r) const {
+        i32 bl = l / B, br = r / B;
+        if (bl == br)
+            return inBlock(l, r);
+        i32 ret = std::min(inBlock(l, bl * B + B - 1), inBlock(br * B, r));
+        if (bl + 1 < br) {
+            i32 k = std::bit_width((u32)(br - bl - 1)) - 1;
+            ret = std::min({ret, table[k * nb + bl + 1],
+                            table[k * nb + br - (1 << k)]});
+        }
+        return ret;
+    }
+
   public:
     Lca() = default;
     Lca(const GraphType &G, i32 root) { init(G, root); }
 
     void init(const GraphType &G, i32 root) {
-        idx.resize(G.numNodes());
-        dist = G.distances(root, -1);
-        depth.clear();
-        auto ord = G.inorder(root);
-        for (u32 i = 0; i < ord.size(); ++i) {
-            depth.emplace_back(dist[ord[i]], ord[i]);
-            idx[ord[i]] = i;
+        const i32 N = G.numNodes();
+        ord.clear();
+        ord.reserve(N);
+        tin.assign(N, -1);
+        val.assign(N, 0);
+        dist.assign(N, 0);
+
+        // {頂点, 親の tin}
+        std::vector<std::pair<i32, i32>> stk = {{root, 0}};
+        while (!stk.empty()) {
+            auto [v, p] = stk.back();
+            stk.pop_back();
+            tin[v] = ord.size();
+            val[tin[v]] = p;
+            ord.push_back(v);
+            for (auto &e : G[v]) {
+                i32 w = e->dst(v);
+                if (tin[w] != -1)
+                    continue;
+                dist[w] = dist[v] + e->cost;
+                stk.emplace_back(w, tin[v]);
+            }
+        }
+
+        // 単調スタックの先頭は最上位ビット
+        const i32 n = ord.size();
+        mask.assign(n, 0);
+        u32 cur = 0;
+        for (i32 i = 0; i < n; ++i) {
+            if (i % B == 0)
+                cur = 0;
+            while (cur) {
+                i32 top = 31 - std::countl_zero(cur);
+                if (val[i / B * B + top] <= val[i])
+                    break;
+                cur ^= 1u << top;
+            }
+            cur |= 1u << (i % B);
+            mask[i] = cur;
         }
-        sps.init(depth);
+        nb = (n + B - 1) / B;
+        const i32 levels = std::max(1, (i32)std::bit_width((u32)nb));
+        table.assign((size_t)levels * nb, 0);
+        for (i32 b = 0; b < nb; ++b)
+            table[b] = inBlock(b * B, std::min(n, b * B + B) - 1);
+        for (i32 k = 1; k < levels; ++k)
+            for (i32 b = 0; b + (1 << k) <= nb; ++b)
+                table[k * nb + b] =
+                    std::min(table[(k - 1) * nb + b],
+                             table[(k - 1) * nb + b + (1 << (k - 1))]);
     }
 
-    i32 getAncestor(i32 a, i32 b) {
-        i32 idxl = idx[a], idxr = idx[b];
-        if (idxl > idxr)
-            std::swap(idxl, idxr);
-        return sps.get(idxl, idxr + 1).second;
+    i32 getAncestor(i32 a, i32 b) const {
+        if (a == b)
+            return a;
+        i32 l = tin[a], r = tin[b];
+        if (l > r)
+            std::swap(l, r);
+        return ord[rangeMin(l + 1, r)];
     }
 
-    Cost distance(i32 u, i32 v) {
+    Cost distance(i32 u, i32 v) const {
         return dist[u] + dist[v] - 2 * dist[getAncestor(u, v)];
     }
 
-    Cost getDepth(i32 x) { return dist[x]; }
+    Cost getDepth(i32 x) const { return dist[x]; }
+
+    /**
+     * @brief LCA と距離のクエリをまとめて答える
+     * @details クエリを W 個ずつまとめ、参照する表の位置を段階ごとに先読み
+     * してからまとめて答えることで、メモリアクセスの待ちを重ねる。クエリ
+     * の列は num_threads 本のスレッドで分担する
+     * @return i 番目に {queries[i] の LCA, 距離} が入った配列
+     */
+    std::vector<std::pair<i32, Cost>>
+    batch(const std::vector<std::pair<i32, i32>> &queries,
+          i32 num_threads = 1) const {
+        constexpr i32 W = 32;
+        const i32 Q = queries.size();
+        std::vector<std::pair<i32, Cost>> ret(Q);
+        const i32 K = std::min((Q + W - 1) / W, std::max(num_threads, 1) * 8);
+        parallelFor(K, num_threads, [&](i32 k) {
+            const i32 lo = (i64)Q * k / K, hi = (i64)Q * (k + 1) / K;
+            i32 l[W], r[W];
+            for (i32 s = lo; s < hi; s += W) {
+                const i32 w = std::min(W, hi - s);
+                for (i32 j = 0; j < w; ++j) {
+                    auto [a, b] = queries[s + j];
+                    __builtin_prefetch(&tin[a]);
+                    __builtin_prefetch(&tin[b]);
+                    __builtin_prefetch(&dist[a]);
+                    __builtin_prefetch(&dist[b]);
+                }
+                for (i32 j = 0; j < w; ++j) {
+                    auto [a, b] = queries[s + j];
+                    l[j] = std::min(tin[a], tin[b]) + 1;
+                    r[j] = std::max(tin[a], tin[b]);
+                    i32 x = std::min(l[j], r[j]);
+                    __builtin_prefetch(&mask[std::min(x / B * B + B - 1, r[j])]);
+                    __builtin_prefetch(&mask[r[j]]);
+                    __builtin_prefetch(&val[x / B * B]);
+                    __builtin_prefetch(&val[r[j] / B * B]);
+                }
+                for (i32 j = 0; j < w; ++j) {
+                    // a == b のとき l > r となり、tin[a] をそのまま使う
+                    l[j] = (l[j] > r[j] ? r[j] : rangeMin(l[j], r[j]));
+                    __builtin_prefetch(&ord[l[j]]);
+                }
+                for (i32 j = 0; j < w; ++j) {
+                    l[j] = ord[l[j]];
+                    __builtin_prefetch(&dist[l[j]]);
+                }
+                for (i32 j = 0; j < w; ++j) {
+                    auto [a, b] = queries[s + j];
+                    ret[s + j] = {l[j], dist[a] + dist[b] - 2 * dist[l[j]]};
+                }
+            }
+        });
+        return ret;
+    }
 };
 } // namespace gandalfr
@@ -0,0 +1,679 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief フロー用の残余グラフを平坦な配列で保持する
+ * @details 辺 i は順方向の arc と逆方向の arc の対で表される。ノード v から
+ * 出る arc は [arcBegin(v), arcEnd(v)) に詰めて並び、arc a は行き先 to(a)、
+ * 残余容量 residual(a)、コスト cost(a)、対になる arc rev(a) を持つ。
+ * arc の並びは最初にアルゴリズムを呼んだときに構築する
+ */
+class ResidualGraph {
+  public:
+    using Flow = i64;
+    using Cost = i64;
+    static constexpr Flow FMAX = std::numeric_limits<Flow>::max();
+
+  private:
+    i32 N = 0;
+    // 辺ごとの情報 (構築前はこちらが正)
+    std::vector<i32> _src, _dst;
+    std::vector<Flow> _cap, _flow;
+    std::vector<Cost> _edge_cost;
+    // arc ごとの情報
+    std::vector<i32> _ofs, _to, _rev, _eidx, _arc;
+    std::vector<Flow> _res;
+    std::vector<Cost> _cost;
+    std::vector<Cost> _pot; // 最小費用流のポテンシャル
+    bool built = false;
+
+    // 辺の流量を arc から辺ごとの配列に戻す
+    void sync() {
+        if (!built)
+            return;
+        for (i32 i = 0; i < (i32)_arc.size(); ++i)
+            _flow[i] = _res[_rev[_arc[i]]];
+    }
+
+  public:
+    ResidualGraph() = default;
+    explicit ResidualGraph(i32 n) : N(n) {}
+    ResidualGraph(i32 n, i32 m) : N(n) {
+        _src.reserve(m), _dst.reserve(m), _cap.reserve(m), _flow.reserve(m);
+        _edge_cost.reserve(m);
+    }
+
+    /**
+     * @return ノードの数
+     */
+    i32 numNodes() const { return N; }
+
+    /**
+     * @return 辺の数
+     */
+    i32 numEdges() const { return _src.size(); }
+
+    /**
+     * @brief 容量 cap、コスト cost、初期流量 flow の辺を追加する
+     * @return 辺の番号
+     * @attention 構築後に追加すると、次にアルゴリズムを呼んだとき再構築する
+     */
+    i32 addEdge(i32 from, i32 to, Flow cap, Cost cost = 0, Flow flow = 0) {
+        assert(0 <= from && from < N && 0 <= to && to < N);
+        assert(0 <= flow && flow <= cap);
+        sync();
+        built = false;
+        _src.push_back(from);
+        _dst.push_back(to);
+        _cap.push_back(cap);
+        _flow.push_back(flow);
+        _edge_cost.push_back(cost);
+        return _src.size() - 1;
+    }
+
+    /**
+     * @brief arc の並びを O(N+M) で構築する
+     * @details 各ノードの arc は辺の追加順に並ぶ
+     */
+    void build() {
+        if (built)
+            return;
+        sync();
+        const i32 M = _src.size();
+        _ofs.assign(N + 1, 0);
+        for (i32 i = 0; i < M; ++i)
+            ++_ofs[_src[i] + 1], ++_ofs[_dst[i] + 1];
+        for (i32 v = 0; v < N; ++v)
+            _ofs[v + 1] += _ofs[v];
+        std::vector<i32> pos(_ofs.begin(), _ofs.end() - 1);
+        _to.resize(2 * M), _rev.resize(2 * M), _eidx.resize(2 * M);
+        _arc.resize(M);
+        _res.resize(2 * M), _cost.resize(2 * M);
+        for (i32 i = 0; i < M; ++i) {
+            i32 a = pos[_src[i]]++, b = pos[_dst[i]]++;
+            _to[a] = _dst[i], _to[b] = _src[i];
+            _rev[a] = b, _rev[b] = a;
+            _eidx[a] = _eidx[b] = i;
+            _res[a] = _cap[i] - _flow[i], _res[b] = _flow[i];
+            _cost[a] = _edge_cost[i], _cost[b] = -_edge_cost[i];
+            _arc[i] = a;
+        }
+        built = true;
+    }
+
+    // 以下の arc に関する操作は build() 後に使う
+    i32 arcBegin(i32 v) const { return _ofs[v]; }
+    i32 arcEnd(i32 v) const { return _ofs[v + 1]; }
+    i32 to(i32 a) const { return _to[a]; }
+    i32 rev(i32 a) const { return _rev[a]; }
+    Flow residual(i32 a) const { return _res[a]; }
+    Cost cost(i32 a) const { return _cost[a]; }
+    /**
+     * @return arc a が表す辺の番号
+     */
+    i32 edgeOf(i32 a) const { return _eidx[a]; }
+    /**
+     * @return 辺 i の順方向の arc
+     */
+    i32 arcOf(i32 i) const { return _arc[i]; }
+
+    /**
+     * @brief arc a に d だけ流す
+     */
+    void push(i32 a, Flow d) {
+        _res[a] -= d;
+        _res[_rev[a]] += d;
+    }
+
+    // 辺 i の端点・容量・コスト
+    i32 edgeFrom(i32 i) const { return _src[i]; }
+    i32 edgeTo(i32 i) const { return _dst[i]; }
+    Flow capacity(i32 i) const { return _cap[i]; }
+    Cost edgeCost(i32 i) const { return _edge_cost[i]; }
+    /**
+     * @return 辺 i の流量
+     */
+    Flow flow(i32 i) const { return built ? _res[_rev[_arc[i]]] : _flow[i]; }
+
+  private:
+    /**
+     * @brief 残余容量が正で ok(v, a) を満たす arc だけを使う Dinic 法
+     * @details 増加路の探索は明示的なスタックで行い、各ノードで次に見る arc
+     * (current arc) を覚えておく。増加後は最初に飽和した arc の手前まで
+     * 戻って探索を続ける
+     */
+    template <class Admissible>
+    Flow blockingFlows(i32 s, i32 t, Flow limit, const Admissible &ok) {
+        std::vector<i32> level(N), iter(N), que(N), path;
+        Flow flow = 0;
+        while (flow < limit) {
+            // 残余グラフ上の bfs で s からの層を作る
+            std::fill(level.begin(), level.end(), -1);
+            level[s] = 0;
+            i32 qh = 0, qt = 0;
+            que[qt++] = s;
+            while (qh < qt && level[t] == -1) {
+                i32 v = que[qh++];
+                for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a) {
+                    if (_res[a] == 0 || level[_to[a]] != -1 || !ok(v, a))
+                        continue;
+                    level[_to[a]] = level[v] + 1;
+                    que[qt++] = _to[a];
+                }
+            }
+            if (level[t] == -1)
+                break;
+
+            // 層に沿った増加路で閉塞流を求める
+            std::copy(_ofs.begin(), _ofs.end() - 1, iter.begin());
+            path.clear();
+            i32 v = s;
+            while (true) {
+                if (v == t) {
+                    Flow f = limit - flow;
+                    for (i32 a : path)
+                        chmin(f, _res[a]);
+                    i32 cut = path.size();
+                    for (i32 k = path.size() - 1; k >= 0; --k) {
+                        push(path[k], f);
+                        if (_res[path[k]] == 0)
+                            cut = k;
+                    }
+                    flow += f;
+                    if (flow == limit)
+                        break;
+                    path.resize(cut);
+                    v = (cut == 0 ? s : _to[path.back()]);
+                    continue;
+                }
+                i32 &a = iter[v];
+                while (a < _ofs[v + 1] &&
+                       (_res[a] == 0 || level[_to[a]] != level[v] + 1 ||
+                        !ok(v, a)))
+                    ++a;
+                if (a < _ofs[v + 1]) {
+                    path.push_back(a);
+                    v = _to[a];
+                    continue;
+                }
+                // v からは t に届かない
+                level[v] = -1;
+                if (path.empty())
+                    break;
+                path.pop_back();
+                v = (path.empty() ? s : _to[path.back()]);
+                ++iter[v];
+            }
+        }
+        return flow;
+    }
+
+    /**
+     * @brief 負のコストの arc があれば、仮想的な始点からの最短距離を
+     * ポテンシャルの初期値にする
+     * @details 残余グラフが DAG ならトポロジカル順の dp、そうでなければ
+     * ベルマンフォード法による
+     */
+    void initPotential() {
+        _pot.assign(N, 0);
+        const i32 A = _to.size();
+        bool negative = false;
+        for (i32 a = 0; a < A; ++a)
+            negative |= (_res[a] > 0 && _cost[a] < 0);
+        if (!negative)
+            return;
+        std::vector<i32> indeg(N, 0), order;
+        order.reserve(N);
+        for (i32 a = 0; a < A; ++a)
+            if (_res[a] > 0)
+                ++indeg[_to[a]];
+        for (i32 v = 0; v < N; ++v)
+            if (indeg[v] == 0)
+                order.push_back(v);
+        for (i32 i = 0; i < (i32)order.size(); ++i)
+            for (i32 a = _ofs[order[i]]; a < _ofs[order[i] + 1]; ++a)
+                if (_res[a] > 0 && --indeg[_to[a]] == 0)
+                    order.push_back(_to[a]);
+        const bool dag = ((i32)order.size() == N);
+        for (i32 iter = 0; iter < (dag ? 1 : N); ++iter) {
+            bool updated = false;
+            for (i32 i = 0; i < N; ++i) {
+                i32 v = (dag ? order[i] : i);
+                for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a)
+                    if (_res[a] > 0)
+                        updated |= chmin(_pot[_to[a]], _pot[v] + _cost[a]);
+            }
+            if (!updated)
+                break;
+        }
+    }
+
+  public:
+    /**
+     * @brief Dinic 法で s から t へ最大 limit だけ流す
+     * @details 現在の残余グラフから続けて流す
+     * @return 追加で流れた量
+     */
+    Flow dinic(i32 s, i32 t, Flow limit = FMAX) {
+        assert(s != t);
+        build();
+        return blockingFlows(s, t, limit, [](i32, i32) { return true; });
+    }
+
+    /**
+     * @brief s からの正味の流出量
+     */
+    Flow flowValue(i32 s) {
+        build();
+        Flow ret = 0;
+        for (i32 a = _ofs[s]; a < _ofs[s + 1]; ++a)
+            ret += (_arc[_eidx[a]] == a ? _res[_rev[a]] : -_res[a]);
+        return ret;
+    }
+
+    /**
+     * @brief 残余容量が正の arc だけを辿って s から到達できるノード O(N+M)
+     * @details s-t 最大流を流した後なら、これが s を含む極小の最小カットの
+     * s 側になる
+     */
+    std::vector<bool> reachable(i32 s) {
+        build();
+        std::vector<bool> vis(N, false);
+        std::vector<i32> que = {s};
+        vis[s] = true;
+        for (i32 qh = 0; qh < (i32)que.size(); ++qh) {
+            i32 v = que[qh];
+            for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a) {
+                if (_res[a] > 0 && !vis[_to[a]]) {
+                    vis[_to[a]] = true;
+                    que.push_back(_to[a]);
+                }
+            }
+        }
+        return vis;
+    }
+
+    /**
+     * @brief 全ての辺の流量を 0 に戻す O(M)
+     */
+    void resetFlow() {
+        build();
+        for (i32 i = 0; i < (i32)_arc.size(); ++i) {
+            _res[_arc[i]] = _cap[i];
+            _res[_rev[_arc[i]]] = 0;
+        }
+    }
+
+    /**
+     * @brief 辺 i の容量を cap に変更する O(1)
+     * @attention 辺 i の流量が cap 以下であること
+     */
+    void setCapacity(i32 i, Flow cap) {
+        assert(0 <= flow(i) && flow(i) <= cap);
+        if (built)
+            _res[_arc[i]] = cap - _res[_rev[_arc[i]]];
+        _cap[i] = cap;
+    }
+
+    /**
+     * @brief 辺 i の容量を cap に変更する
+     * @details 流量が cap を超えた場合は超過分だけ減らし、辺の両端に生じた
+     * 過不足を、まず流量を保つ経路 (u -> v、t や s を経由する u -> v) で、
+     * 残りを流量を減らす経路 (u -> s, t -> v) で解消して実行可能な s-t
+     * フローに戻す。u -> t と s -> v を別々に流すと、最大でない流れでは
+     * 流量が増えてしまうので、t (s) を経由する分は両側を同じ量だけ流す。
+     * その後 dinic(s, t) を呼べば、現在の流れから続けて最大流が求まる
+     * @return s-t フローの流量の減少量 (負にならない)
+     */
+    Flow changeCapacity(i32 i, Flow cap, i32 s, i32 t) {
+        assert(cap >= 0 && s != t);
+        build();
+        const i32 a = _arc[i], u = _src[i], v = _dst[i];
+        const Flow over = std::max<Flow>(0, _res[_rev[a]] - cap);
+        const Flow before = (over > 0 ? flowValue(s) : 0);
+        // 流量を cap まで減らしておく
+        _res[_rev[a]] -= over;
+        _res[a] = cap - _res[_rev[a]];
+        _cap[i] = cap;
+        if (over == 0 || u == v)
+            return 0;
+
+        // u に超過、v に不足が生じる。s と t は超過・不足を吸収できる
+        auto terminal = [&](i32 x) { return x == s || x == t; };
+        Flow surplus = (terminal(u) ? 0 : over);
+        Flow deficit = (terminal(v) ? 0 : over);
+        auto move = [&](i32 from, i32 to, Flow &x, Flow &y) {
+            if (x == 0 || y == 0 || from == to)
+                return (Flow)0;
+            Flow f = dinic(from, to, std::min(x, y));
+            x -= f, y -= f;
+            return f;
+        };
+        // u -> w -> v と流す。w -> v に流せなかった分は u に押し戻す
+        auto through = [&](i32 w) {
+            if (surplus == 0 || deficit == 0 || w == u || w == v)
+                return (Flow)0;
+            Flow f = dinic(u, w, std::min(surplus, deficit));
+            Flow g = (f > 0 ? dinic(w, v, f) : 0);
+            if (f > g)
+                dinic(w, u, f - g);
+            surplus -= g, deficit -= g;
+            return g;
+        };
+        Flow unlimited = FMAX;
+        if (u == t && v == s) {
+            // t -> s の流れは s の流出を増やしていたので、t から s に戻す
+            Flow rest = over;
+            move(t, s, rest, unlimited);
+            assert(rest == 0);
+        }
+        // 流量を減らした分を s -> v または u -> t で元に戻す
+        if (u == s)
+            move(s, v, unlimited, deficit);
+        if (v == t)
+            move(u, t, surplus, unlimited);
+        while (surplus > 0 || deficit > 0) {
+            // 流量を保つ経路を優先する
+            Flow moved = move(u, v, surplus, deficit);
+            moved += through(t);
+            moved += through(s);
+            moved += move(u, s, surplus, unlimited);
+            moved += move(t, v, unlimited, deficit);
+            assert(moved > 0);
+        }
+        return before - flowValue(s);
+    }
+
+    /**
+     * @brief 最小費用流 (primal-dual 法)
+     * @details ポテンシャルで付け替えたコストの上で Dijkstra 法を行い、
+     * 最短路に含まれる arc だけからなるグラフで Dinic 法を行って、同じ
+     * 費用の増加路にまとめて流す。負のコストの辺があれば最初に 1 度だけ
+     * ポテンシャルを初期化する
+     * @attention 残余グラフに負閉路があってはならない
+     * @return 流量とコストの関係を表す折れ線の頂点 {流量, コスト} のリスト。
+     * 先頭は {0, 0}、末尾は実際に流した量とそのコスト
+     */
+    std::vector<std::pair<Flow, Cost>> minCostSlope(i32 s, i32 t,
+                                                    Flow limit = FMAX) {
+        assert(s != t);
+        constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+        using Pair = std::pair<Cost, i32>;
+        build();
+        initPotential();
+        std::vector<std::pair<Flow, Cost>> slope = {{0, 0}};
+        std::vector<Cost> dist(N);
+        std::vector<bool> done(N);
+        std::vector<Pair> heap;
+        Flow flow = 0;
+        Cost cost = 0, prev_unit = CMAX;
+        while (flow < limit) {
+            std::fill(dist.begin(), dist.end(), CMAX);
+            std::fill(done.begin(), done.end(), false);
+            dist[s] = 0;
+            heap.assign(1, {0, s});
+            while (!heap.empty()) {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<Pair>());
+                auto [d, v] = heap.back();
+                heap.pop_back();
+                if (done[v])
+                    continue;
+                done[v] = true;
+                if (v == t)
+                    break;
+                for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a) {
+                    i32 w = _to[a];
+                    if (_res[a] == 0)
+                        continue;
+                    Cost nd = d + _cost[a] + _pot[v] - _pot[w];
+                    if (nd < dist[w]) {
+                        dist[w] = nd;
+                        heap.emplace_back(nd, w);
+                        std::push_heap(heap.begin(), heap.end(),
+                                       std::greater<Pair>());
+                    }
+                }
+            }
+            if (!done[t])
+                break;
+            // 付け替えたコストは非負のまま、t への最短路上の arc では 0 になる
+            for (i32 v = 0; v < N; ++v)
+                _pot[v] += std::min(dist[v], dist[t]);
+
+            const Cost unit = _pot[t] - _pot[s];
+            Flow f = blockingFlows(s, t, limit - flow, [&](i32 v, i32 a) {
+                return _cost[a] + _pot[v] - _pot[_to[a]] == 0;
+            });
+            flow += f, cost += f * unit;
+            if (unit == prev_unit) {
+                slope.back() = {flow, cost};
+            } else {
+                slope.emplace_back(flow, cost);
+            }
+            prev_unit = unit;
+        }
+        return slope;
+    }
+
+    /**
+     * @brief 最小費用流 (primal-dual 法) で s から t へ最大 limit だけ流す
+     * @return {流した量, そのコスト}
+     */
+    std::pair<Flow, Cost> minCostFlow(i32 s, i32 t, Flow limit = FMAX) {
+        return minCostSlope(s, t, limit).back();
+    }
+
+    /**
+     * @return 直前の最小費用流で求めたポテンシャル
+     * @details 残余容量が正の任意の arc u -> v について
+     * cost + p[u] - p[v] >= 0 が成り立つ (双対問題の実行可能解)
+     */
+    const std::vector<Cost> &potentials() const { return _pot; }
+
+    /**
+     * @brief コストスケーリング法で現在の流れを最小費用循環流に改善する
+     * @details コストを (N + 1) 倍し、eps を 1/16 ずつ小さくしながら
+     * eps-最適な流れを push-relabel で求める (refine)。eps = 1 になれば
+     * 元のコストで最適になる。各ノードの流量保存は保たれるので、
+     * 実行可能な s-t フローに対して呼べば同じ流量の最小費用流が得られる
+     * @attention 現在の流れは流量保存を満たしていること
+     * @attention N^2 * (コストの絶対値の最大値) が i64 に収まること
+     */
+    void minCostCirculation() {
+        constexpr Cost SCALE = 16;
+        build();
+        const i32 A = _to.size();
+        std::vector<Cost> c(A), p(N, 0);
+        Cost eps = 0;
+        for (i32 a = 0; a < A; ++a) {
+            c[a] = _cost[a] * (N + 1);
+            chmax(eps, std::abs(c[a]));
+        }
+        std::vector<Flow> excess(N, 0);
+        std::vector<i32> iter(N), stk;
+        while (eps > 1) {
+            eps = std::max<Cost>(1, eps / SCALE);
+            // 付け替えたコストが負の arc を飽和させて 0-最適にする
+            for (i32 v = 0; v < N; ++v) {
+                for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a) {
+                    if (_res[a] > 0 && c[a] + p[v] - p[_to[a]] < 0) {
+                        excess[v] -= _res[a], excess[_to[a]] += _res[a];
+                        push(a, _res[a]);
+                    }
+                }
+            }
+            for (i32 v = 0; v < N; ++v) {
+                iter[v] = _ofs[v];
+                if (excess[v] > 0)
+                    stk.push_back(v);
+            }
+            while (!stk.empty()) {
+                i32 v = stk.back();
+                stk.pop_back();
+                while (excess[v] > 0) {
+                    if (iter[v] == _ofs[v + 1]) {
+                        // 再ラベル: 少なくとも 1 本の arc を許容にする
+                        Cost best = std::numeric_limits<Cost>::min();
+                        for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a)
+                            if (_res[a] > 0)
+                                chmax(best, p[_to[a]] - c[a]);
+                        assert(best != std::numeric_limits<Cost>::min());
+                        p[v] = best - eps;
+                        iter[v] = _ofs[v];
+                        continue;
+                    }
+                    i32 a = iter[v], w = _to[a];
+                    if (_res[a] > 0 && c[a] + p[v] - p[w] < 0) {
+                        Flow d = std::min(excess[v], _res[a]);
+                        if (excess[w] <= 0 && excess[w] + d > 0)
+                            stk.push_back(w);
+                        push(a, d);
+                        excess[v] -= d, excess[w] += d;
+                        if (excess[v] == 0)
+                            break;
+                    }
+                    ++iter[v];
+                }
+            }
+        }
+    }
+
+  private:
+    /**
+     * @brief 最高ラベルの頂点から順に超過を sink へ押し出す
+     * @param excess 各頂点の超過
+     * @param fixed ラベルを N に固定して押し出しの対象にしない頂点
+     * @details 周期的に sink からの逆向き bfs でラベルを付け直し (global
+     * relabeling)、あるラベルの頂点がいなくなったらそれより上の頂点を
+     * 見捨てる (gap heuristic)。sink に届かない超過は残る
+     */
+    void dischargeAll(std::vector<Flow> &excess, i32 sink, i32 fixed) {
+        const i32 M = _to.size();
+        std::vector<i32> h(N), cnt(N + 1), iter(N), que(N);
+        std::vector<std::vector<i32>> bucket(N);
+        i32 hi = 0;
+        auto active = [&](i32 v) {
+            return excess[v] > 0 && v != sink && v != fixed && h[v] < N;
+        };
+        auto globalRelabel = [&] {
+            std::fill(h.begin(), h.end(), N);
+            std::fill(cnt.begin(), cnt.end(), 0);
+            for (auto &b : bucket)
+                b.clear();
+            h[sink] = 0;
+            i32 qh = 0, qt = 0;
+            que[qt++] = sink;
+            while (qh < qt) {
+                i32 v = que[qh++];
+                ++cnt[h[v]];
+                for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a) {
+                    i32 u = _to[a];
+                    if (h[u] != N || u == fixed || _res[_rev[a]] == 0)
+                        continue;
+                    h[u] = h[v] + 1;
+                    que[qt++] = u;
+                }
+            }
+            hi = 0;
+            for (i32 v = 0; v < N; ++v) {
+                iter[v] = _ofs[v];
+                if (active(v)) {
+                    bucket[h[v]].push_back(v);
+                    chmax(hi, h[v]);
+                }
+            }
+        };
+
+        globalRelabel();
+        i64 work = 0;
+        while (true) {
+            while (hi >= 0 && bucket[hi].empty())
+                --hi;
+            if (hi < 0)
+                break;
+            i32 v = bucket[hi].back();
+            bucket[hi].pop_back();
+            if (h[v] != hi || !active(v))
+                continue;
+
+            // 許容 arc に押し出す
+            for (i32 &a = iter[v]; a < _ofs[v + 1]; ++a) {
+                i32 w = _to[a];
+                if (_res[a] == 0 || h[w] != h[v] - 1)
+                    continue;
+                Flow d = std::min(excess[v], _res[a]);
+                bool was_active = active(w);
+                push(a, d);
+                excess[v] -= d, excess[w] += d;
+                if (!was_active && active(w))
+                    bucket[h[w]].push_back(w);
+                if (excess[v] == 0)
+                    break;
+            }
+            if (excess[v] == 0)
+                continue;
+
+            // 再ラベル
+            i32 old = h[v], nh = N;
+            for (i32 a = _ofs[v]; a < _ofs[v + 1]; ++a)
+                if (_res[a] > 0)
+                    chmin(nh, h[_to[a]] + 1);
+            work += _ofs[v + 1] - _ofs[v] + 12;
+            if (--cnt[old] == 0) {
+                // old より上の頂点は sink に届かない
+                for (i32 u = 0; u < N; ++u) {
+                    if (old < h[u] && h[u] < N) {
+                        --cnt[h[u]];
+                        h[u] = N;
+                    }
+                }
+                h[v] = N;
+                continue;
+            }
+            h[v] = std::min(nh, N);
+            iter[v] = _ofs[v];
+            if (h[v] < N) {
+                ++cnt[h[v]];
+                bucket[h[v]].push_back(v);
+                hi = h[v];
+            }
+            if (work > 6 * N + M) {
+                globalRelabel();
+                work = 0;
+            }
+        }
+    }
+
+  public:
+    /**
+     * @brief 最高ラベル優先の push-relabel 法で s から t へ流す O(V^2 sqrt(E))
+     * @details 前半で最大の先流 (preflow) を求め、後半で t に届かなかった
+     * 超過を s に押し戻して実行可能な流れにする
+     * @return 追加で流れた量
+     */
+    Flow pushRelabel(i32 s, i32 t) {
+        assert(s != t);
+        build();
+        std::vector<Flow> excess(N, 0);
+        for (i32 a = _ofs[s]; a < _ofs[s + 1]; ++a) {
+            Flow d = _res[a];
+            if (d == 0 || _to[a] == s)
+                continue;
+            push(a, d);
+            excess[s] -= d, excess[_to[a]] += d;
+        }
+        dischargeAll(excess, t, s);
+        dischargeAll(excess, s, t);
+        return excess[t];
+    }
+};
+
+} // namespace gandalfr
@@ -0,0 +1,176 @@
+#pragma once
+#include <vector>
+
+#include "../data_structure/LazySegtree.hpp"
+#include "../data_structure/Segtree.hpp"
+#include "Graph.hpp"
+#include "Hld.hpp"
+
+namespace gandalfr {
+
+namespace internal {
+
+/**
+ * @brief 区間の積と、同じ区間を逆順に掛けた積の組
+ * @details 非可換な演算でも、パスを上る向きの区間は rev を使えばよい
+ */
+template <class S> struct BiFold {
+    S fwd, rev;
+};
+
+} // namespace internal
+
+/**
+ * @brief 木のパスと部分木に対する区間積のクエリ
+ * @details HLD の行きがけ順に並べた値をセグ木で持ち、パスは Hld::path
+ * の区間ごとに積を取って繋ぐ。各ノードには順向きと逆向きの積を持つので、
+ * 非可換な演算でもパスの向きどおりの積になる
+ * @param edge true なら値を辺 (v, parent(v)) に持ち、vals[v] がその値に
+ * なる (根の値は使わない)
+ */
+template <class S, S (*op)(S, S), S (*e)(), bool is_weighted = UNWEIGHTED>
+class TreePathQuery {
+  private:
+    using GraphType = Graph<is_weighted, UNDIRECTED>;
+    using Node = internal::BiFold<S>;
+
+    static Node nodeOp(Node a, Node b) {
+        return {op(a.fwd, b.fwd), op(b.rev, a.rev)};
+    }
+    static Node nodeE() { return {e(), e()}; }
+
+    Hld<is_weighted, UNDIRECTED> _hld;
+    bool _edge;
+    Segtree<Node, nodeOp, nodeE> _seg;
+
+    static std::vector<Node> layout(const Hld<is_weighted, UNDIRECTED> &hld,
+                                    const std::vector<S> &vals) {
+        std::vector<Node> ret(vals.size(), nodeE());
+        for (i32 v = 0; v < (i32)vals.size(); ++v)
+            ret[hld.node(v).first] = {vals[v], vals[v]};
+        return ret;
+    }
+
+  public:
+    TreePathQuery(const GraphType &G, const std::vector<S> &vals,
+                  i32 root = 0, bool edge = false)
+        : _hld(G, root), _edge(edge), _seg(layout(_hld, vals)) {}
+
+    /**
+     * @brief v の値を x にする O(log N)
+     */
+    void set(i32 v, S x) { _seg.set(_hld.node(v).first, {x, x}); }
+
+    S get(i32 v) const { return _seg.get(_hld.node(v).first).fwd; }
+
+    /**
+     * @brief u から v へのパス上の値を、u の側から順に掛けた積 O(log^2 N)
+     */
+    S prod(i32 u, i32 v) const {
+        S ret = e();
+        _hld.path(u, v, _edge, [&](i32 l, i32 r, bool reversed) {
+            Node x = _seg.prod(l, r);
+            ret = op(ret, (reversed ? x.rev : x.fwd));
+        });
+        return ret;
+    }
+
+    /**
+     * @brief v の部分木の値の積 O(log N)
+     * @details 非可換な演算では HLD の行きがけ順 (重い子が先) の積になる
+     */
+    S subtreeProd(i32 v) const {
+        auto [l, r] = _hld.node(v);
+        return _seg.prod(l + _edge, r).fwd;
+    }
+
+    const Hld<is_weighted, UNDIRECTED> &hld() const { return _hld; }
+};
+
+/**
+ * @brief 木のパスと部分木に対する区間作用・区間積のクエリ
+ * @details TreePathQuery の遅延セグ木版。作用は順向きと逆向きの積の両方
+ * に掛ける
+ * @param edge true なら値を辺 (v, parent(v)) に持ち、vals[v] がその値に
+ * なる (根の値は使わない)
+ */
+template <class S, S (*op)(S, S), S (*e)(), class F, S (*mapping)(F, S),
+          F (*composition)(F, F), F (*id)(), bool is_weighted = UNWEIGHTED>
+class LazyTreePathQuery {
+  private:
+    using GraphType = Graph<is_weighted, UNDIRECTED>;
+    using Node = internal::BiFold<S>;
+
+    static Node nodeOp(Node a, Node b) {
+        return {op(a.fwd, b.fwd), op(b.rev, a.rev)};
+    }
+    static Node nodeE() { return {e(), e()}; }
+    static Node nodeMapping(F f, Node x) {
+        return {mapping(f, x.fwd), mapping(f, x.rev)};
+    }
+
+    Hld<is_weighted, UNDIRECTED> _hld;
+    bool _edge;
+    LazySegtree<Node, nodeOp, nodeE, F, nodeMapping, composition, id> _seg;
+
+    static std::vector<Node> layout(const Hld<is_weighted, UNDIRECTED> &hld,
+                                    const std::vector<S> &vals) {
+        std::vector<Node> ret(vals.size(), nodeE());
+        for (i32 v = 0; v < (i32)vals.size(); ++v)
+            ret[hld.node(v).first] = {vals[v], vals[v]};
+        return ret;
+    }
+
+  public:
+    LazyTreePathQuery(const GraphType &G, const std::vector<S> &vals,
+                      i32 root = 0, bool edge = false)
+        : _hld(G, root), _edge(edge), _seg(layout(_hld, vals)) {}
+
+    /**
+     * @brief v の値を x にする O(log N)
+     */
+    void set(i32 v, S x) { _seg.set(_hld.node(v).first, {x, x}); }
+
+    S get(i32 v) { return _seg.get(_hld.node(v).first).fwd; }
+
+    /**
+     * @brief u から v へのパス上の値を、u の側から順に掛けた積 O(log^2 N)
+     */
+    S prod(i32 u, i32 v) {
+        S ret = e();
+        _hld.path(u, v, _edge, [&](i32 l, i32 r, bool reversed) {
+            Node x = _seg.prod(l, r);
+            ret = op(ret, (reversed ? x.rev : x.fwd));
+        });
+        return ret;
+    }
+
+    /**
+     * @brief u から v へのパス上の値に f を作用させる O(log^2 N)
+     */
+    void apply(i32 u, i32 v, F f) {
+        _hld.path(u, v, _edge,
+                  [&](i32 l, i32 r, bool) { _seg.apply(l, r, f); });
+    }
+
+    /**
+     * @brief v の部分木の値の積 O(log N)
+     * @details 非可換な演算では HLD の行きがけ順 (重い子が先) の積になる
+     */
+    S subtreeProd(i32 v) {
+        auto [l, r] = _hld.node(v);
+        return _seg.prod(l + _edge, r).fwd;
+    }
+
+    /**
+     * @brief v の部分木の値に f を作用させる O(log N)
+     */
+    void subtreeApply(i32 v, F f) {
+        auto [l, r] = _hld.node(v);
+        _seg.apply(l + _edge, r, f);
+    }
+
+    const Hld<is_weighted, UNDIRECTED> &hld() const { return _hld; }
+};
+
+} // namespace gandalfr
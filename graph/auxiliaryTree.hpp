@@ -2,6 +2,7 @@
 
 #include "../standard/HashMap.hpp"
 #include "Lca.hpp"
+#include "dfs.hpp"
 #include <stack>
 
 namespace gandalfr {
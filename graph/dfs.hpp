@@ -4,44 +4,37 @@
 
 namespace gandalfr {
 
+/**
+ * @brief 明示的なスタックによる dfs
+ * @details 行きがけ (pre)・通りがけ (in)・帰りがけ (post) の各タイミングで
+ * result にノードを追加する。順序は再帰で書いた場合と一致する
+ */
 GRAPH_TEMPLATE
-void GRAPH_TYPE::preorderImpl(i32 cu, std::vector<bool> &visited,
-                              std::vector<i32> &result) const {
-    result.push_back(cu);
-    for (auto &e : G[cu]) {
-        i32 to = e->dst(cu);
-        if (visited[to])
+template <bool pre, bool in, bool post>
+void GRAPH_TYPE::dfsImpl(i32 start, std::vector<bool> &visited,
+                         std::vector<i32> &result) const {
+    std::vector<std::pair<i32, u32>> stk; // {ノード, 次に見る辺}
+    stk.emplace_back(start, 0);
+    if constexpr (pre)
+        result.push_back(start);
+    while (!stk.empty()) {
+        auto &[cu, i] = stk.back();
+        if (i == G[cu].size()) {
+            if constexpr (in || post)
+                result.push_back(cu);
+            stk.pop_back();
             continue;
-        visited[to] = true;
-        preorderImpl(to, visited, result);
-    }
-}
-
-GRAPH_TEMPLATE
-void GRAPH_TYPE::inorderImpl(i32 cu, std::vector<bool> &visited,
-                             std::vector<i32> &result) const {
-    for (auto &e : G[cu]) {
-        i32 to = e->dst(cu);
-        if (visited[to])
-            continue;
-        visited[to] = true;
-        result.push_back(cu);
-        inorderImpl(to, visited, result);
-    }
-    result.push_back(cu);
-}
-
-GRAPH_TEMPLATE
-void GRAPH_TYPE::postorderImpl(i32 cu, std::vector<bool> &visited,
-                               std::vector<i32> &result) const {
-    for (auto &e : G[cu]) {
-        i32 to = e->dst(cu);
+        }
+        i32 to = G[cu][i++]->dst(cu);
         if (visited[to])
             continue;
         visited[to] = true;
-        postorderImpl(to, visited, result);
+        if constexpr (in)
+            result.push_back(cu);
+        if constexpr (pre)
+            result.push_back(to);
+        stk.emplace_back(to, 0);
     }
-    result.push_back(cu);
 }
 
 GRAPH_TEMPLATE
@@ -49,7 +42,7 @@ std::vector<i32> GRAPH_TYPE::preorder(i32 start) const {
     std::vector<i32> result;
     std::vector<bool> visited(N, false);
     visited[start] = true;
-    preorderImpl(start, visited, result);
+    dfsImpl<true, false, false>(start, visited, result);
     return result;
 }
 
@@ -59,7 +52,7 @@ std::vector<i32> GRAPH_TYPE::preorder(i32 start,
     assert(!visited[start]);
     std::vector<i32> result;
     visited[start] = true;
-    preorderImpl(start, visited, result);
+    dfsImpl<true, false, false>(start, visited, result);
     return result;
 }
 
@@ -68,7 +61,7 @@ std::vector<i32> GRAPH_TYPE::inorder(i32 start) const {
     std::vector<i32> result;
     std::vector<bool> visited(N, false);
     visited[start] = true;
-    inorderImpl(start, visited, result);
+    dfsImpl<false, true, false>(start, visited, result);
     return result;
 }
 
@@ -78,7 +71,7 @@ std::vector<i32> GRAPH_TYPE::inorder(i32 start,
     assert(!visited[start]);
     std::vector<i32> result;
     visited[start] = true;
-    inorderImpl(start, visited, result);
+    dfsImpl<false, true, false>(start, visited, result);
     return result;
 }
 
@@ -87,7 +80,7 @@ std::vector<i32> GRAPH_TYPE::postorder(i32 start) const {
     std::vector<i32> result;
     std::vector<bool> visited(N, false);
     visited[start] = true;
-    postorderImpl(start, visited, result);
+    dfsImpl<false, false, true>(start, visited, result);
     return result;
 }
 
@@ -97,7 +90,7 @@ std::vector<i32> GRAPH_TYPE::postorder(i32 start,
     assert(!visited[start]);
     std::vector<i32> result;
     visited[start] = true;
-    postorderImpl(start, visited, result);
+    dfsImpl<false, false, true>(start, visited, result);
     return result;
 }
 
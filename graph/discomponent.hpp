@@ -7,8 +7,8 @@ namespace gandalfr {
 
 GRAPH_TEMPLATE
 std::tuple<std::vector<GRAPH_TYPE>, std::vector<i32>, std::vector<i32>>
-GRAPH_TYPE::discomponent() const {
-    auto uf = buildUnionFind();
+GRAPH_TYPE::discomponent(i32 num_threads) const {
+    auto uf = buildUnionFind(num_threads);
     i32 n_grps = uf.numGroups();
     auto grps = uf.getAllGroups();
 
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#include "../other/parallel.hpp"
+#include "Graph.hpp"
+#include "ResidualGraph.hpp"
+
+namespace gandalfr {
+
+GRAPH_TEMPLATE
+Graph<WEIGHTED, UNDIRECTED> GRAPH_TYPE::gomoryHuTree(i32 num_threads) const {
+    static_assert(!is_directed);
+    // 容量 c の無向辺は、容量 2c の辺に c だけ流れた状態として表す
+    ResidualGraph base(N, E.size());
+    for (auto &e : E) {
+        i64 c = 1;
+        if constexpr (is_weighted)
+            c = e->cost;
+        assert(c >= 0);
+        base.addEdge(e->v0, e->v1, 2 * c, 0, c);
+    }
+    base.build();
+
+    // Gusfield の方法: ノード i と par[i] の最小カットを順に求める
+    // i, i+1, ... のカットを並列に先読みし、計算に使った par が
+    // 確定した値と一致している分だけ採用する
+    const i32 T = std::max(num_threads, 1);
+    std::vector<i32> par(N, 0), used(T);
+    std::vector<i64> cut(N, 0), val(T);
+    std::vector<ResidualGraph> R(T);
+    std::vector<std::vector<bool>> side(T);
+    for (i32 i = 1; i < N;) {
+        const i32 k = std::min(T, N - i);
+        parallelFor(k, num_threads, [&](i32 j) {
+            used[j] = par[i + j];
+            R[j] = base;
+            val[j] = R[j].dinic(i + j, used[j]);
+            side[j] = R[j].reachable(i + j);
+        });
+        for (i32 j = 0; j < k && par[i] == used[j]; ++j, ++i) {
+            cut[i] = val[j];
+            for (i32 w = i + 1; w < N; ++w)
+                if (side[j][w] && par[w] == par[i])
+                    par[w] = i;
+        }
+    }
+
+    Graph<WEIGHTED, UNDIRECTED> ret(N, std::max(N - 1, 0));
+    for (i32 v = 1; v < N; ++v)
+        ret.addEdge(v, par[v], cut[v]);
+    return ret;
+}
+
+} // namespace gandalfr
@@ -5,19 +5,36 @@
 
 namespace gandalfr {
 
+/**
+ * @brief start を根とする dfs 木の上で ord, low を計算する
+ * @details 明示的なスタックで辿る。辺を見る順序は再帰で書いた場合と一致する
+ */
 GRAPH_TEMPLATE
-void GRAPH_TYPE::lowlinkImpl(i32 cu, i32 e_id, i32 &id, std::vector<i32> &ord,
+void GRAPH_TYPE::lowlinkImpl(i32 start, std::vector<i32> &ord,
                              std::vector<i32> &low,
                              Graph<is_weighted, DIRECTED> &tree) const {
-    ord[cu] = low[cu] = id++;
-    for (auto &e : G[cu]) {
+    i32 id = 0;
+    // {ノード, 直前に使った辺の id, 次に見る辺}
+    std::vector<std::tuple<i32, i32, u32>> stk;
+    ord[start] = low[start] = id++;
+    stk.emplace_back(start, -1, 0);
+    while (!stk.empty()) {
+        auto &[cu, e_id, i] = stk.back();
+        if (i == G[cu].size()) {
+            i32 ch = cu;
+            stk.pop_back();
+            if (!stk.empty())
+                chmin(low[std::get<0>(stk.back())], low[ch]);
+            continue;
+        }
+        auto &e = G[cu][i++];
         i32 to = e->dst(cu);
         if (e->id == e_id) // 直前に使った辺を戻らない
             continue;
         if (ord[to] == -1) {
             tree.addEdge({cu, to, e->cost, e->id});
-            lowlinkImpl(to, e->id, id, ord, low, tree);
-            chmin(low[cu], low[to]);
+            ord[to] = low[to] = id++;
+            stk.emplace_back(to, e->id, 0);
         } else {
             chmin(low[cu], ord[to]);
         }
@@ -34,8 +51,7 @@ GRAPH_TYPE::lowlink() const {
         if (ord[i] != -1) {
             continue;
         }
-        i32 id = 0;
-        lowlinkImpl(i, -1, id, ord, low, tree);
+        lowlinkImpl(i, ord, low, tree);
     }
     return {ord, low, tree};
 }
@@ -1,26 +1,191 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <utility>
+#include <vector>
 
+#include "../data_structure/ConcurrentUnionFind.hpp"
 #include "../data_structure/UnionFind.hpp"
+#include "../other/parallel.hpp"
 #include "Graph.hpp"
 
 namespace gandalfr {
 
+namespace internal {
+
+/**
+ * @brief 最小全域森を求めるための辺の配列
+ * @details 辺は (コスト, 番号) の辞書順で比べるので、どのアルゴリズムでも
+ * 同じ森が得られる
+ */
+template <class Cost> struct MstEdges {
+    i32 n;
+    std::vector<i32> src, dst;
+    std::vector<Cost> cost;
+
+    bool less(i32 a, i32 b) const {
+        return cost[a] < cost[b] || (cost[a] == cost[b] && a < b);
+    }
+    i32 size() const { return src.size(); }
+};
+
+/**
+ * @brief Kruskal 法 O(M log M)
+ * @return 選んだ辺の番号 (昇順に並ぶ)
+ */
+template <class Cost> std::vector<i32> kruskal(const MstEdges<Cost> &g) {
+    std::vector<std::pair<Cost, i32>> key(g.size());
+    for (i32 i = 0; i < g.size(); ++i)
+        key[i] = {g.cost[i], i};
+    std::sort(key.begin(), key.end());
+    std::vector<i32> ret;
+    UnionFind uf(g.n);
+    for (auto [c, i] : key)
+        if (uf.unite(g.src[i], g.dst[i]))
+            ret.push_back(i);
+    return ret;
+}
+
+/**
+ * @brief filter-Kruskal 法 期待 O(M + N log N log(M/N))
+ * @details 辺をピボットで 2 つに分け、軽い側を先に処理してから、重い側の
+ * うち既に同じ成分に入った辺を捨てて続ける。区間は明示的なスタックで持つ
+ * @return 選んだ辺の番号 (昇順に並ぶ)
+ */
+template <class Cost>
+std::vector<i32> filterKruskal(const MstEdges<Cost> &g) {
+    constexpr i32 THRESHOLD = 1024;
+    std::vector<i32> ord(g.size()), ret;
+    std::iota(ord.begin(), ord.end(), 0);
+    UnionFind uf(g.n);
+    auto less = [&](i32 a, i32 b) { return g.less(a, b); };
+    auto alive = [&](i32 e) { return !uf.isSame(g.src[e], g.dst[e]); };
+    u64 seed = 88172645463325252ULL;
+    std::vector<std::pair<i32, i32>> stk = {{0, g.size()}};
+    while (!stk.empty() && uf.numGroups() > 1) {
+        auto [l, r] = stk.back();
+        stk.pop_back();
+        auto first = ord.begin();
+        // 既に同じ成分に入った辺を捨てる
+        r = std::partition(first + l, first + r, alive) - first;
+        if (r - l <= THRESHOLD) {
+            std::sort(first + l, first + r, less);
+            for (i32 k = l; k < r; ++k)
+                if (uf.unite(g.src[ord[k]], g.dst[ord[k]]))
+                    ret.push_back(ord[k]);
+            continue;
+        }
+        // 3 つの辺の中央値をピボットにすると、両側とも空にならない
+        i32 c[3];
+        for (i32 &x : c) {
+            seed ^= seed << 7, seed ^= seed >> 9;
+            x = ord[l + seed % (r - l)];
+        }
+        if (c[0] == c[1] || c[1] == c[2] || c[0] == c[2])
+            c[0] = ord[l], c[1] = ord[(l + r) / 2], c[2] = ord[r - 1];
+        std::sort(c, c + 3, less);
+        i32 pivot = c[1];
+        i32 m = std::partition(first + l, first + r,
+                               [&](i32 e) { return !less(pivot, e); }) -
+                first;
+        stk.emplace_back(m, r);
+        stk.emplace_back(l, m);
+    }
+    return ret;
+}
+
+/**
+ * @brief Borůvka 法 O(M log N)
+ * @details 各ラウンドで成分ごとに外へ出る最小の辺を CAS で選び、
+ * ConcurrentUnionFind で並列に併合する。辺は作業単位ごとのリストに分けて
+ * 持ち、成分の内側になった辺はその場で捨てる
+ * @return 選んだ辺の番号 (昇順に並ぶ)
+ */
+template <class Cost>
+std::vector<i32> boruvka(const MstEdges<Cost> &g, i32 num_threads) {
+    const i32 M = g.size();
+    const i32 K = std::max(1, std::min(num_threads * 4, M / 4096 + 1));
+    const i32 KN = std::max(1, std::min(num_threads * 4, g.n / 4096 + 1));
+    std::vector<std::vector<i32>> part(K), found(KN);
+    for (i32 k = 0; k < K; ++k) {
+        i32 l = (i64)M * k / K, r = (i64)M * (k + 1) / K;
+        part[k].resize(r - l);
+        std::iota(part[k].begin(), part[k].end(), l);
+    }
+    std::vector<i32> comp(g.n), best(g.n, -1), ret;
+    std::iota(comp.begin(), comp.end(), 0);
+    ConcurrentUnionFind uf(g.n);
+    while (true) {
+        parallelFor(K, num_threads, [&](i32 k) {
+            auto chmin = [&](i32 c, i32 e) {
+                std::atomic_ref<i32> b(best[c]);
+                i32 cur = b.load(std::memory_order_relaxed);
+                while ((cur == -1 || g.less(e, cur)) &&
+                       !b.compare_exchange_weak(cur, e,
+                                                std::memory_order_relaxed))
+                    ;
+            };
+            i32 sz = 0;
+            for (i32 e : part[k]) {
+                i32 cu = comp[g.src[e]], cv = comp[g.dst[e]];
+                if (cu == cv)
+                    continue;
+                part[k][sz++] = e;
+                chmin(cu, e), chmin(cv, e);
+            }
+            part[k].resize(sz);
+        });
+        // 選ばれた辺は (重複を除いて) 森をなすので、併合の順序によらない
+        parallelFor(KN, num_threads, [&](i32 k) {
+            for (i32 c = (i64)g.n * k / KN; c < (i64)g.n * (k + 1) / KN; ++c) {
+                i32 e = best[c];
+                if (e != -1 && uf.unite(g.src[e], g.dst[e]))
+                    found[k].push_back(e);
+            }
+        });
+        bool updated = false;
+        for (auto &f : found) {
+            updated |= !f.empty();
+            ret.insert(ret.end(), f.begin(), f.end());
+            f.clear();
+        }
+        if (!updated)
+            break;
+        parallelFor(KN, num_threads, [&](i32 k) {
+            for (i32 v = (i64)g.n * k / KN; v < (i64)g.n * (k + 1) / KN; ++v)
+                comp[v] = uf.leader(v), best[v] = -1;
+        });
+    }
+    std::sort(ret.begin(), ret.end(),
+              [&](i32 a, i32 b) { return g.less(a, b); });
+    return ret;
+}
+
+} // namespace internal
+
 GRAPH_TEMPLATE
-GRAPH_TYPE GRAPH_TYPE::mst() const {
+GRAPH_TYPE GRAPH_TYPE::mst(MstAlgorithm algo, i32 num_threads) const {
     static_assert(is_weighted && !is_directed);
-    Graph ret(N, N - 1);
-    std::vector<i32> idx(E.size());
-    std::iota(idx.begin(), idx.end(), 0);
-    std::sort(idx.begin(), idx.end(),
-              [&](i32 i, i32 j) { return E[i]->cost < E[j]->cost; });
-
-    UnionFind uf(N);
-    for (i32 i : idx) {
-        if (!uf.isSame(E[i]->v0, E[i]->v1)) {
-            uf.unite(E[i]->v0, E[i]->v1);
-            ret.addEdge(*E[i]);
-        }
+    internal::MstEdges<Cost> g{N, {}, {}, {}};
+    g.src.resize(E.size()), g.dst.resize(E.size()), g.cost.resize(E.size());
+    for (i32 i = 0; i < (i32)E.size(); ++i)
+        g.src[i] = E[i]->v0, g.dst[i] = E[i]->v1, g.cost[i] = E[i]->cost;
+
+    std::vector<i32> used;
+    switch (algo) {
+    case MstAlgorithm::FILTER_KRUSKAL:
+        used = internal::filterKruskal(g);
+        break;
+    case MstAlgorithm::BORUVKA:
+        used = internal::boruvka(g, num_threads);
+        break;
+    default:
+        used = internal::kruskal(g);
     }
+    Graph ret(N, used.size());
+    for (i32 i : used)
+        ret.addEdge(*E[i]);
     return ret;
 }
 
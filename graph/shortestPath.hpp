@@ -1,58 +1,725 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <span>
+#include <type_traits>
+
+#include "../data_structure/BucketQueue.hpp"
+#include "../data_structure/RadixHeap.hpp"
+#include "../other/parallel.hpp"
 #include "Graph.hpp"
 
 namespace gandalfr {
 
-GRAPH_TEMPLATE
-std::vector<GRAPH_EDGE_PTR> GRAPH_TYPE::dijkstraImpl(std::vector<Cost> &dist,
-                                                     i32 start_node) const {
+/**
+ * @brief 最短路クエリの作業領域
+ * @details 距離・直前の辺・確定フラグ・キューを持ち、同じグラフへのクエリ間で
+ * 使い回す。各配列はタイムスタンプで管理するので、クエリごとの初期化は O(1)
+ */
+template <bool is_weighted> class ShortestPathWorkspace {
+  public:
+    using EdgeType = Edge<is_weighted>;
+    using Cost = typename EdgeType::Cost;
+    static constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+
+  private:
+    // 両方向探索のために 2 方向分を持つ (片方向のクエリは 0 番のみ使う)
+    struct Side {
+        std::vector<Cost> dist;
+        std::vector<const EdgeType *> prev;
+        std::vector<u32> seen, done; // stamp と一致すれば有効
+    };
+    i32 N = 0;
+    u32 stamp = 0;
+    std::array<Side, 2> sides;
+    std::vector<u32> target;
+    std::vector<i32> _touched;
+
+    Side &use(i32 s) {
+        auto &sd = sides[s];
+        if ((i32)sd.dist.size() != N) {
+            sd.dist.assign(N, CMAX);
+            sd.prev.assign(N, nullptr);
+            sd.seen.assign(N, 0);
+            sd.done.assign(N, 0);
+        }
+        return sd;
+    }
+
+  public:
+    // 探索で使うキュー
+    std::array<std::vector<std::pair<Cost, i32>>, 2> heap;
+    RadixHeap<u64, i32> radix;
+    BucketQueue<i32> bucket;
+    std::array<std::vector<i32>, 2> frontier;
+    std::vector<i32> next;
+    std::vector<std::pair<i32, Cost>> sorted_sources; // 多始点 bfs で使う
+
+    ShortestPathWorkspace() = default;
+    explicit ShortestPathWorkspace(i32 n) { prepare(n); }
+
+    i32 size() const { return N; }
+
+    /**
+     * @brief ノード数 n のグラフに対する新しいクエリを始める
+     * @details n が前回と同じならならし O(1)
+     */
+    void prepare(i32 n) {
+        N = n;
+        use(0);
+        if (++stamp == 0) {
+            for (auto &sd : sides) {
+                std::fill(sd.seen.begin(), sd.seen.end(), 0);
+                std::fill(sd.done.begin(), sd.done.end(), 0);
+            }
+            std::fill(target.begin(), target.end(), 0);
+            stamp = 1;
+        }
+        _touched.clear();
+    }
+
+    // 以下は探索の内部で使う
+    Cost get(i32 s, i32 v) const {
+        return sides[s].seen[v] == stamp ? sides[s].dist[v] : CMAX;
+    }
+    void set(i32 s, i32 v, Cost d, const EdgeType *e) {
+        auto &sd = use(s);
+        sd.seen[v] = stamp;
+        sd.dist[v] = d;
+        sd.prev[v] = e;
+    }
+    const EdgeType *prevEdge(i32 s, i32 v) const { return sides[s].prev[v]; }
+    bool isSettled(i32 s, i32 v) const { return sides[s].done[v] == stamp; }
+    void settle(i32 s, i32 v) {
+        sides[s].done[v] = stamp;
+        if (s == 0)
+            _touched.push_back(v);
+    }
+    // 新しく追加されたとき true
+    bool addTarget(i32 v) {
+        if ((i32)target.size() != N)
+            target.assign(N, 0);
+        if (target[v] == stamp)
+            return false;
+        target[v] = stamp;
+        return true;
+    }
+    bool isTarget(i32 v) const { return target[v] == stamp; }
+
+    /**
+     * @return 直前のクエリで確定した v の距離 (確定していなければ CMAX)
+     */
+    Cost dist(i32 v) const { return isSettled(0, v) ? sides[0].dist[v] : CMAX; }
+
+    /**
+     * @return 直前のクエリで v の距離が確定したか
+     */
+    bool reached(i32 v) const { return isSettled(0, v); }
+
+    /**
+     * @return 直前のクエリで距離が確定したノードのリスト (確定順)
+     */
+    const std::vector<i32> &touched() const { return _touched; }
+};
+
+namespace internal {
+
+// {始点, 初期距離} の列。Cost は他の引数から推論させる
+template <class Cost>
+using SourceList = std::type_identity_t<std::span<const std::pair<i32, Cost>>>;
+
+// 辺のコストの範囲と始点の初期距離からキューを選ぶ
+template <class Cost>
+HeapPolicy selectHeap(Cost min_cost, Cost max_cost, SourceList<Cost> sources) {
+    // これ以下の最大コストならバケットの走査が radix heap より軽い
+    constexpr Cost BUCKET_MAX_COST = 1 << 10;
+    if (min_cost < 0)
+        return HeapPolicy::BINARY;
+    Cost lo = std::numeric_limits<Cost>::max(), hi = 0;
+    for (auto &[v, d] : sources) {
+        if (d < 0)
+            return HeapPolicy::BINARY;
+        chmin(lo, d);
+        chmax(hi, d);
+    }
+    if (max_cost <= BUCKET_MAX_COST && hi - lo <= BUCKET_MAX_COST)
+        return HeapPolicy::BUCKET;
+    return HeapPolicy::RADIX;
+}
+
+// targets を ws に登録し、異なる targets の個数を返す
+template <bool is_weighted>
+i32 registerTargets(ShortestPathWorkspace<is_weighted> &ws,
+                    std::span<const i32> targets) {
+    i32 ret = 0;
+    for (i32 t : targets)
+        ret += ws.addTarget(t);
+    return ret;
+}
+
+/**
+ * @brief Dijkstra 法の本体
+ * @param adj adj(cu, f) で cu から出る各辺について f(to, cost, 辺) を呼ぶ
+ * @param max_cost 辺のコストの最大値 (BUCKET のときのみ使う)
+ * @details ws.prepare() 済みであること。targets が空でなければ、全て確定
+ * した時点で打ち切る
+ */
+template <HeapPolicy policy, bool is_weighted, class Cost, class Adj>
+void dijkstra(ShortestPathWorkspace<is_weighted> &ws, const Adj &adj,
+              SourceList<Cost> sources, std::span<const i32> targets,
+              Cost bound, Cost max_cost) {
+    static_assert(policy != HeapPolicy::AUTO);
+    using EdgeType = Edge<is_weighted>;
     using Pair = std::pair<Cost, i32>;
-    std::priority_queue<Pair, std::vector<Pair>, std::greater<Pair>> q;
-    q.push({0, start_node});
-    std::vector<EdgePtr> prev_edge(N, nullptr);
-    std::vector<bool> visited(N, false);
-    while (!q.empty()) {
-        Cost cur_dist = q.top().first;
-        i32 cu = q.top().second;
-        q.pop();
-
-        if (visited[cu])
+    constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+
+    auto &h = ws.heap[0];
+    if constexpr (policy == HeapPolicy::RADIX) {
+        ws.radix.clear();
+    } else if constexpr (policy == HeapPolicy::BUCKET) {
+        Cost lo = CMAX, hi = 0;
+        for (auto &[v, d] : sources) {
+            chmin(lo, d);
+            chmax(hi, d);
+        }
+        if (sources.empty())
+            lo = 0;
+        ws.bucket.reset(std::max(max_cost, hi - lo), lo);
+    } else {
+        h.clear();
+    }
+    auto empty = [&] {
+        if constexpr (policy == HeapPolicy::RADIX) {
+            return ws.radix.empty();
+        } else if constexpr (policy == HeapPolicy::BUCKET) {
+            return ws.bucket.empty();
+        } else {
+            return h.empty();
+        }
+    };
+    auto push = [&](Cost d, i32 v) {
+        if constexpr (policy == HeapPolicy::RADIX) {
+            assert(d >= 0);
+            ws.radix.push(d, v);
+        } else if constexpr (policy == HeapPolicy::BUCKET) {
+            assert(d >= 0);
+            ws.bucket.push(d, v);
+        } else {
+            h.emplace_back(d, v);
+            std::push_heap(h.begin(), h.end(), std::greater<Pair>());
+        }
+    };
+    auto pop = [&]() -> Pair {
+        if constexpr (policy == HeapPolicy::RADIX) {
+            return ws.radix.pop();
+        } else if constexpr (policy == HeapPolicy::BUCKET) {
+            return ws.bucket.pop();
+        } else {
+            std::pop_heap(h.begin(), h.end(), std::greater<Pair>());
+            Pair ret = h.back();
+            h.pop_back();
+            return ret;
+        }
+    };
+
+    for (auto &[v, d] : sources) {
+        if (d > bound || ws.get(0, v) <= d)
             continue;
-        visited[cu] = true;
+        ws.set(0, v, d, nullptr);
+        push(d, v);
+    }
+    i32 remaining = registerTargets(ws, targets);
+
+    while (!empty()) {
+        auto [cur_dist, cu] = pop();
+
+        if (ws.isSettled(0, cu))
+            continue;
+        ws.settle(0, cu);
+        if (remaining > 0 && ws.isTarget(cu) && --remaining == 0)
+            break;
 
-        for (auto &e : G[cu]) {
-            i32 to = e->dst(cu);
-            Cost alt = cur_dist + e->cost;
-            if (dist[to] <= alt)
+        adj(cu, [&](i32 to, Cost cost, const EdgeType *e) {
+            Cost alt = cur_dist + cost;
+            if (alt > bound || ws.get(0, to) <= alt)
+                return;
+            ws.set(0, to, alt, e);
+            push(alt, to);
+        });
+    }
+}
+
+/**
+ * @brief 重みなしグラフの多始点 bfs
+ * @details 始点を初期距離でソートし、キューとマージしながら取り出す。
+ * 発見した時点で距離が確定する。引数の意味は dijkstra と同じ。始点が
+ * 整列していなければ ws の配列に写してソートする
+ */
+template <bool is_weighted, class Cost, class Adj>
+void bfs(ShortestPathWorkspace<is_weighted> &ws, const Adj &adj,
+         SourceList<Cost> sources, std::span<const i32> targets, Cost bound) {
+    using EdgeType = Edge<is_weighted>;
+    constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+    auto by_dist = [](const auto &a, const auto &b) {
+        return a.second < b.second;
+    };
+    if (!std::is_sorted(sources.begin(), sources.end(), by_dist)) {
+        auto &buf = ws.sorted_sources;
+        buf.assign(sources.begin(), sources.end());
+        std::sort(buf.begin(), buf.end(), by_dist);
+        sources = buf;
+    }
+    i32 remaining = registerTargets(ws, targets);
+
+    auto &q = ws.frontier[0];
+    q.clear();
+    u32 head = 0, si = 0;
+    while (true) {
+        i32 cu;
+        // 距離の小さい方から取り出す
+        if (si < sources.size() &&
+            (head == q.size() || sources[si].second <= ws.get(0, q[head]))) {
+            auto [v, d] = sources[si++];
+            if (d > bound || ws.get(0, v) <= d)
                 continue;
-            prev_edge[to] = e;
-            dist[to] = alt;
-            q.push({alt, to});
+            ws.set(0, v, d, nullptr);
+            ws.settle(0, v);
+            cu = v;
+        } else if (head < q.size()) {
+            cu = q[head++];
+        } else {
+            break;
         }
+
+        if (remaining > 0 && ws.isTarget(cu) && --remaining == 0)
+            break;
+
+        Cost nd = ws.get(0, cu) + 1;
+        if (nd > bound)
+            continue;
+        adj(cu, [&](i32 to, Cost, const EdgeType *e) {
+            if (ws.get(0, to) != CMAX)
+                return;
+            ws.set(0, to, nd, e);
+            ws.settle(0, to);
+            q.push_back(to);
+        });
     }
-    return prev_edge;
 }
 
-GRAPH_TEMPLATE
-std::vector<GRAPH_EDGE_PTR> GRAPH_TYPE::bfsImpl(std::vector<i32> &dist,
-                                                i32 start_node) const {
-    std::queue<i32> q;
-    q.push(start_node);
-    std::vector<EdgePtr> prev_edge(N, nullptr);
-    while (!q.empty()) {
-        i32 cu = q.front();
-        q.pop();
-        for (auto &e : G[cu]) {
-            i32 to = e->dst(cu);
-            if (dist[to] != CMAX)
+/**
+ * @brief 直前の辺を辿って start_node から end_node までの経路を復元する
+ */
+template <bool is_weighted>
+std::vector<Edge<is_weighted>>
+restorePath(const ShortestPathWorkspace<is_weighted> &ws, i32 side,
+            i32 start_node, i32 end_node) {
+    i32 cu = end_node;
+    std::vector<Edge<is_weighted>> route;
+    while (cu != start_node) {
+        auto e = ws.prevEdge(side, cu);
+        if (cu == e->v0) {
+            route.push_back(e->rev());
+        } else {
+            route.push_back(*e);
+        }
+        cu = e->dst(cu);
+    }
+    return {route.rbegin(), route.rend()};
+}
+
+/**
+ * @brief 両方向探索による復元付き最短経路
+ * @param fadj 順方向の隣接 (dijkstra と同じ形式)
+ * @param badj 逆方向の隣接
+ * @details 重みつきなら両側から Dijkstra 法、重みなしなら両側から 1 層ずつ
+ * bfs を行う。いずれもキュー (フロンティア) の小さい側を進める
+ */
+template <bool is_weighted, class Adj, class RAdj>
+std::vector<Edge<is_weighted>>
+bidirectionalSearch(ShortestPathWorkspace<is_weighted> &ws, const Adj &fadj,
+                    const RAdj &badj, i32 start_node, i32 end_node) {
+    using EdgeType = Edge<is_weighted>;
+    using Cost = typename EdgeType::Cost;
+    constexpr Cost CMAX = std::numeric_limits<Cost>::max();
+    ws.set(0, start_node, 0, nullptr);
+    ws.set(1, end_node, 0, nullptr);
+
+    // mu := これまでに見つかった最短の s-t 路の長さ、meet := その合流点
+    Cost mu = CMAX;
+    i32 meet = -1;
+    if (start_node == end_node)
+        mu = 0, meet = start_node;
+
+    auto relax = [&](i32 side, i32 to, Cost alt, const EdgeType *e) {
+        if (ws.get(side, to) <= alt)
+            return false;
+        ws.set(side, to, alt, e);
+        Cost other = ws.get(side ^ 1, to);
+        if (other != CMAX && alt + other < mu) {
+            mu = alt + other;
+            meet = to;
+        }
+        return true;
+    };
+    auto adj = [&](i32 side, i32 cu, auto &&f) {
+        if (side == 0) {
+            fadj(cu, f);
+        } else {
+            badj(cu, f);
+        }
+    };
+
+    if constexpr (is_weighted) {
+        using Pair = std::pair<Cost, i32>;
+        auto &q = ws.heap;
+        for (i32 side = 0; side < 2; ++side)
+            q[side].clear();
+        q[0].emplace_back(0, start_node);
+        q[1].emplace_back(0, end_node);
+        while (!q[0].empty() && !q[1].empty()) {
+            if (q[0].front().first + q[1].front().first >= mu)
+                break;
+            i32 side = (q[0].size() <= q[1].size() ? 0 : 1);
+            std::pop_heap(q[side].begin(), q[side].end(), std::greater<Pair>());
+            auto [cur_dist, cu] = q[side].back();
+            q[side].pop_back();
+            if (ws.isSettled(side, cu))
                 continue;
-            prev_edge[to] = e;
-            dist[to] = dist[cu] + 1;
-            q.push(to);
+            ws.settle(side, cu);
+            adj(side, cu, [&](i32 to, Cost cost, const EdgeType *e) {
+                assert(cost >= 0);
+                if (!relax(side, to, cur_dist + cost, e))
+                    return;
+                q[side].emplace_back(cur_dist + cost, to);
+                std::push_heap(q[side].begin(), q[side].end(),
+                               std::greater<Pair>());
+            });
+        }
+    } else {
+        auto &frontier = ws.frontier;
+        auto &next = ws.next;
+        frontier[0].assign(1, start_node);
+        frontier[1].assign(1, end_node);
+        // 合流した層を最後まで展開してから止める
+        while (meet == -1 && !frontier[0].empty() && !frontier[1].empty()) {
+            i32 side = (frontier[0].size() <= frontier[1].size() ? 0 : 1);
+            next.clear();
+            for (i32 cu : frontier[side]) {
+                Cost nd = ws.get(side, cu) + 1;
+                adj(side, cu, [&](i32 to, Cost, const EdgeType *e) {
+                    if (relax(side, to, nd, e))
+                        next.push_back(to);
+                });
+            }
+            frontier[side].swap(next);
+        }
+    }
+
+    if (meet == -1)
+        return {};
+    auto route = restorePath(ws, 0, start_node, meet);
+    for (i32 cu = meet; cu != end_node;) {
+        auto e = ws.prevEdge(1, cu);
+        route.push_back(cu == e->v0 ? *e : e->rev());
+        cu = e->dst(cu);
+    }
+    return route;
+}
+
+// d の [i0, i1) x [j0, j1) の区画を k in [k0, k1) を経由して更新する
+template <class Cost>
+void floydWarshallTile(Cost *d, i32 n, i32 i0, i32 i1, i32 j0, i32 j1, i32 k0,
+                       i32 k1) {
+    for (i32 k = k0; k < k1; ++k) {
+        const Cost *dk = d + (i64)k * n;
+        for (i32 i = i0; i < i1; ++i) {
+            Cost *di = d + (i64)i * n;
+            const Cost dik = di[k];
+            for (i32 j = j0; j < j1; ++j)
+                di[j] = std::min(di[j], dik + dk[j]);
         }
     }
-    return prev_edge;
+}
+
+/**
+ * @brief 行優先の n x n 行列 d に対するブロック化したワーシャルフロイド法
+ * @details 各フェーズで対角ブロック → 同じ行・列のブロック → 残りのブロック
+ * の順に更新し、後の 2 段はブロック単位で並列に処理する
+ * @attention 未到達は十分大きな値で表し、和が溢れないこと
+ */
+template <class Cost>
+void blockedFloydWarshall(Cost *d, i32 n, i32 num_threads) {
+    constexpr i32 B = 64;
+    const i32 nb = (n + B - 1) / B;
+    auto lo = [&](i32 b) { return b * B; };
+    auto hi = [&](i32 b) { return std::min(n, (b + 1) * B); };
+
+    for (i32 kb = 0; kb < nb; ++kb) {
+        const i32 k0 = lo(kb), k1 = hi(kb);
+        floydWarshallTile(d, n, k0, k1, k0, k1, k0, k1);
+
+        // kb 行目と kb 列目のブロック
+        parallelFor(2 * nb, num_threads, [&](i32 t) {
+            i32 b = t >> 1;
+            if (b == kb)
+                return;
+            if (t & 1) {
+                floydWarshallTile(d, n, lo(b), hi(b), k0, k1, k0, k1);
+            } else {
+                floydWarshallTile(d, n, k0, k1, lo(b), hi(b), k0, k1);
+            }
+        });
+
+        // 残りのブロックは互いに独立
+        parallelFor(nb, num_threads, [&](i32 ib) {
+            if (ib == kb)
+                return;
+            for (i32 jb = 0; jb < nb; ++jb) {
+                if (jb != kb)
+                    floydWarshallTile(d, n, lo(ib), hi(ib), lo(jb), hi(jb),
+                                      k0, k1);
+            }
+        });
+    }
+}
+
+/**
+ * @brief 仮想的な始点から全頂点へ長さ 0 の辺を張ったベルマンフォード法
+ * @param adj dijkstra と同じ形式の隣接
+ * @param h ポテンシャルの格納先。返り値が true のとき、任意の辺 u -> v について
+ * cost + h[u] - h[v] >= 0 が成り立つ
+ * @return 負閉路が存在しないか
+ */
+template <class Cost, class Adj>
+bool bellmanFordPotential(i32 n, const Adj &adj, std::vector<Cost> &h) {
+    h.assign(n, 0);
+    for (i32 iter = 0; iter <= n; ++iter) {
+        bool updated = false;
+        for (i32 cu = 0; cu < n; ++cu) {
+            adj(cu, [&](i32 to, Cost cost, const auto *) {
+                if (h[cu] + cost < h[to]) {
+                    h[to] = h[cu] + cost;
+                    updated = true;
+                }
+            });
+        }
+        if (!updated)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 始点ごとに Dijkstra 法 (重みなしなら bfs) を行う全点対間最短路
+ * @param adj dijkstra と同じ形式の隣接
+ * @param table 行優先の n x n の表 (確保済み)。未到達は invalid
+ * @details 負の辺があればベルマンフォード法で求めたポテンシャルで辺の
+ * コストを非負に付け替える (Johnson 法)。始点をいくつかの塊に分け、
+ * 塊ごとに作業領域を 1 つ使い回して num_threads 本のスレッドで処理する
+ * @return 負閉路が存在しないか (存在すれば table は変更しない)
+ */
+template <bool is_weighted, class Cost, class Adj>
+bool allPairsDijkstra(i32 n, const Adj &adj, Cost *table, Cost invalid,
+                      i32 num_threads) {
+    std::vector<Cost> h(n, 0);
+    Cost min_cost = 0;
+    if constexpr (is_weighted) {
+        for (i32 cu = 0; cu < n; ++cu)
+            adj(cu, [&](i32, Cost cost, const auto *) {
+                chmin(min_cost, cost);
+            });
+        if (min_cost < 0 && !bellmanFordPotential(n, adj, h))
+            return false;
+    }
+    auto reduced = [&](i32 cu, auto &&f) {
+        adj(cu, [&](i32 to, Cost cost, const Edge<is_weighted> *e) {
+            f(to, cost + h[cu] - h[to], e);
+        });
+    };
+    Cost max_cost = 0;
+    if constexpr (is_weighted) {
+        for (i32 cu = 0; cu < n; ++cu)
+            reduced(cu, [&](i32, Cost cost, const auto *) {
+                chmax(max_cost, cost);
+            });
+    }
+    const HeapPolicy policy = selectHeap<Cost>(0, max_cost, {});
+
+    // スレッドごとの仕事量を均すため、スレッド数より多めの塊に分ける
+    const i32 num_chunks = std::min(n, std::max(num_threads, 1) * 8);
+    parallelFor(num_chunks, num_threads, [&](i32 c) {
+        ShortestPathWorkspace<is_weighted> ws(n);
+        const i32 s0 = (i64)n * c / num_chunks,
+                  s1 = (i64)n * (c + 1) / num_chunks;
+        for (i32 s = s0; s < s1; ++s) {
+            ws.prepare(n);
+            const std::pair<i32, Cost> src(s, 0);
+            if constexpr (!is_weighted) {
+                bfs(ws, adj, {&src, 1}, {}, std::numeric_limits<Cost>::max());
+            } else if (policy == HeapPolicy::BUCKET) {
+                dijkstra<HeapPolicy::BUCKET>(ws, reduced, {&src, 1}, {},
+                                             std::numeric_limits<Cost>::max(),
+                                             max_cost);
+            } else {
+                dijkstra<HeapPolicy::RADIX>(ws, reduced, {&src, 1}, {},
+                                            std::numeric_limits<Cost>::max(),
+                                            max_cost);
+            }
+            Cost *row = table + (i64)s * n;
+            std::fill(row, row + n, invalid);
+            for (i32 v : ws.touched())
+                row[v] = ws.dist(v) - h[s] + h[v];
+        }
+    });
+    return true;
+}
+
+/**
+ * @brief 方向最適化 bfs
+ * @param ofs, to 順方向の隣接 (CSR 形式)
+ * @param rofs, rto 逆方向の隣接。無向グラフなら順方向と同じものを渡す
+ * @details フロンティアから出る辺が未訪問の頂点から出る辺に比べて多いときは
+ * 未訪問の頂点側から親を探す (bottom-up)。フロンティアが小さくなったら
+ * 通常の top-down に戻る。各層は num_threads 本のスレッドで分担する
+ * @return 各ノードの距離 (未到達は -1)
+ */
+inline std::vector<i32>
+directionOptimizingBfs(std::span<const i32> ofs, std::span<const i32> to,
+                       std::span<const i32> rofs, std::span<const i32> rto,
+                       const std::vector<i32> &sources, i32 num_threads) {
+    // 切り替えの閾値 (Beamer et al. の推奨値)
+    constexpr i64 ALPHA = 14, BETA = 24;
+    // 並列化の単位 (top-down はフロンティアの頂点数、bottom-up は 64 頂点)
+    constexpr i32 TD_CHUNK = 1 << 10, BU_CHUNK = 1 << 6;
+    const i32 n = ofs.size() - 1, W = (n + 63) >> 6;
+    auto deg = [&](i32 v) -> i64 { return ofs[v + 1] - ofs[v]; };
+
+    std::vector<i32> dist(n, -1), frontier;
+    std::vector<u64> cur_bits, next_bits;
+    i64 frontier_edges = 0, unexplored_edges = to.size();
+    for (i32 s : sources) {
+        if (dist[s] != -1)
+            continue;
+        dist[s] = 0;
+        frontier.push_back(s);
+        frontier_edges += deg(s);
+    }
+    unexplored_edges -= frontier_edges;
+    i64 frontier_size = frontier.size();
+    bool bottom_up = false;
+
+    for (i32 level = 1; frontier_size > 0; ++level) {
+        if (!bottom_up && frontier_edges > unexplored_edges / ALPHA) {
+            bottom_up = true;
+            cur_bits.assign(W, 0);
+            for (i32 v : frontier)
+                cur_bits[v >> 6] |= 1ull << (v & 63);
+        } else if (bottom_up && frontier_size < n / BETA) {
+            bottom_up = false;
+            frontier.clear();
+            for (i32 w = 0; w < W; ++w)
+                for (u64 b = cur_bits[w]; b; b &= b - 1)
+                    frontier.push_back((w << 6) | std::countr_zero(b));
+        }
+
+        if (bottom_up) {
+            // 各チャンクは自分の担当する dist と next_bits の語にのみ書く
+            next_bits.assign(W, 0);
+            const i32 nc = (W + BU_CHUNK - 1) / BU_CHUNK;
+            std::vector<std::pair<i64, i64>> found(nc); // {頂点数, 辺数}
+            parallelFor(nc, num_threads, [&](i32 c) {
+                const i32 v0 = c * BU_CHUNK * 64,
+                          v1 = std::min(n, (c + 1) * BU_CHUNK * 64);
+                for (i32 v = v0; v < v1; ++v) {
+                    if (dist[v] != -1)
+                        continue;
+                    for (i32 a = rofs[v]; a < rofs[v + 1]; ++a) {
+                        i32 u = rto[a];
+                        if (cur_bits[u >> 6] >> (u & 63) & 1) {
+                            dist[v] = level;
+                            next_bits[v >> 6] |= 1ull << (v & 63);
+                            ++found[c].first;
+                            found[c].second += deg(v);
+                            break;
+                        }
+                    }
+                }
+            });
+            cur_bits.swap(next_bits);
+            frontier_size = frontier_edges = 0;
+            for (auto [cnt, edges] : found) {
+                frontier_size += cnt;
+                frontier_edges += edges;
+            }
+        } else {
+            const i32 nc = (frontier.size() + TD_CHUNK - 1) / TD_CHUNK;
+            std::vector<std::vector<i32>> next(nc);
+            parallelFor(nc, num_threads, [&](i32 c) {
+                const i32 i1 =
+                    std::min<i32>(frontier.size(), (c + 1) * TD_CHUNK);
+                for (i32 i = c * TD_CHUNK; i < i1; ++i) {
+                    i32 u = frontier[i];
+                    for (i32 a = ofs[u]; a < ofs[u + 1]; ++a) {
+                        std::atomic_ref<i32> d(dist[to[a]]);
+                        i32 unvisited = -1;
+                        if (d.load(std::memory_order_relaxed) == -1 &&
+                            d.compare_exchange_strong(
+                                unvisited, level, std::memory_order_relaxed))
+                            next[c].push_back(to[a]);
+                    }
+                }
+            });
+            frontier.clear();
+            for (auto &nx : next)
+                frontier.insert(frontier.end(), nx.begin(), nx.end());
+            frontier_size = frontier.size();
+            frontier_edges = 0;
+            for (i32 v : frontier)
+                frontier_edges += deg(v);
+        }
+        unexplored_edges -= frontier_edges;
+    }
+    return dist;
+}
+
+} // namespace internal
+
+GRAPH_TEMPLATE
+HeapPolicy
+GRAPH_TYPE::selectHeap(std::span<const std::pair<i32, Cost>> sources) const {
+    return internal::selectHeap(cost_min, cost_max, sources);
+}
+
+GRAPH_TEMPLATE
+template <HeapPolicy policy>
+void GRAPH_TYPE::shortestPathImpl(
+    ShortestPathWorkspace<is_weighted> &ws,
+    std::span<const std::pair<i32, Cost>> sources, std::span<const i32> targets,
+    Cost bound) const {
+    auto adj = [&](i32 cu, auto &&f) {
+        for (auto &e : G[cu])
+            f(e->dst(cu), e->cost, e.get());
+    };
+    if constexpr (!is_weighted) {
+        internal::bfs(ws, adj, sources, targets, bound);
+    } else if constexpr (policy == HeapPolicy::AUTO) {
+        switch (selectHeap(sources)) {
+        case HeapPolicy::RADIX:
+            shortestPathImpl<HeapPolicy::RADIX>(ws, sources, targets, bound);
+            break;
+        case HeapPolicy::BUCKET:
+            shortestPathImpl<HeapPolicy::BUCKET>(ws, sources, targets, bound);
+            break;
+        default:
+            shortestPathImpl<HeapPolicy::BINARY>(ws, sources, targets, bound);
+        }
+    } else {
+        internal::dijkstra<policy>(ws, adj, sources, targets, bound, cost_max);
+    }
 }
 
 /**
@@ -62,74 +729,186 @@ std::vector<GRAPH_EDGE_PTR> GRAPH_TYPE::bfsImpl(std::vector<i32> &dist,
  * @return 各ノードまでの最短距離のリスト
  */
 GRAPH_TEMPLATE
+template <HeapPolicy policy>
 std::vector<GRAPH_COST_TYPE> GRAPH_TYPE::distances(i32 start_node,
                                                    Cost invalid) const {
-    std::vector<Cost> dist(N, CMAX);
-    dist[start_node] = 0;
-
-    if constexpr (is_weighted) {
-        dijkstraImpl(dist, start_node);
-    } else {
-        bfsImpl(dist, start_node);
-    }
+    return distances<policy>({{start_node, 0}}, invalid);
+}
 
-    for (auto &x : dist)
-        if (x == CMAX)
-            x = invalid;
+/**
+ * @brief 多始点・打ち切りつきの最短距離
+ * @param sources {始点, 初期距離} のリスト
+ * @param invalid 到達不能な (または打ち切られた) 頂点に格納される値
+ * @param targets 空でなければ、これらの距離が全て確定した時点で打ち切る
+ * @param bound 距離が bound を超える頂点は探索しない
+ */
+GRAPH_TEMPLATE
+template <HeapPolicy policy>
+std::vector<GRAPH_COST_TYPE>
+GRAPH_TYPE::distances(const std::vector<std::pair<i32, Cost>> &sources,
+                      Cost invalid, const std::vector<i32> &targets,
+                      Cost bound) const {
+    ShortestPathWorkspace<is_weighted> ws;
+    distances<policy>(ws, sources, targets, bound);
+    std::vector<Cost> dist(N, invalid);
+    for (i32 v : ws.touched())
+        dist[v] = ws.dist(v);
     return dist;
 }
 
+/**
+ * @brief 作業領域を使い回す最短距離
+ * @return 距離が確定したノードのリスト (距離は ws.dist(v) で得る)
+ */
+GRAPH_TEMPLATE
+template <HeapPolicy policy>
+const std::vector<i32> &
+GRAPH_TYPE::distances(ShortestPathWorkspace<is_weighted> &ws,
+                      const std::vector<std::pair<i32, Cost>> &sources,
+                      const std::vector<i32> &targets, Cost bound) const {
+    ws.prepare(N);
+    shortestPathImpl<policy>(ws, sources, targets, bound);
+    return ws.touched();
+}
+
 /**
  * @brief 復元付き最短経路
  * @attention 到達可能でないとき、空の配列で返る
  * @attention 負閉路があるとき正しい動作を保証しない
  */
 GRAPH_TEMPLATE
+template <HeapPolicy policy>
 std::vector<GRAPH_EDGE_TYPE> GRAPH_TYPE::shortestPath(i32 start_node,
                                                       i32 end_node) const {
-    std::vector<Cost> dist(N, CMAX);
-    dist[start_node] = 0;
-    std::vector<EdgePtr> prev_edge(N, nullptr);
-
-    if constexpr (is_weighted) {
-        prev_edge = dijkstraImpl(dist, start_node);
-    } else {
-        prev_edge = bfsImpl(dist, start_node);
-    }
+    ShortestPathWorkspace<is_weighted> ws;
+    return shortestPath<policy>(start_node, end_node, ws);
+}
 
-    if (dist[end_node] == CMAX)
+GRAPH_TEMPLATE
+template <HeapPolicy policy>
+std::vector<GRAPH_EDGE_TYPE>
+GRAPH_TYPE::shortestPath(i32 start_node, i32 end_node,
+                         ShortestPathWorkspace<is_weighted> &ws) const {
+    // end_node が確定した時点で打ち切る。始点と終点は配列を作らずに渡す
+    const std::pair<i32, Cost> src(start_node, 0);
+    ws.prepare(N);
+    shortestPathImpl<policy>(ws, {&src, 1}, {&end_node, 1}, CMAX);
+    if (!ws.reached(end_node))
         return {};
+    return internal::restorePath(ws, 0, start_node, end_node);
+}
 
-    i32 cu = end_node;
-    std::vector<EdgeType> route;
-    while (cu != start_node) {
-        auto e = prev_edge[cu];
-        if (cu == e->v0) {
-            route.push_back(e->rev());
-        } else {
-            route.push_back(*e);
-        }
-        cu = e->dst(cu);
+GRAPH_TEMPLATE
+std::vector<GRAPH_EDGE_TYPE> GRAPH_TYPE::bidirectionalShortestPath(
+    i32 start_node, i32 end_node, const Graph &R,
+    ShortestPathWorkspace<is_weighted> &ws) const {
+    auto fadj = [&](i32 cu, auto &&f) {
+        for (auto &e : G[cu])
+            f(e->dst(cu), e->cost, e.get());
+    };
+    auto badj = [&](i32 cu, auto &&f) {
+        for (auto &e : R.G[cu])
+            f(e->dst(cu), e->cost, e.get());
+    };
+    ws.prepare(N);
+    return internal::bidirectionalSearch(ws, fadj, badj, start_node, end_node);
+}
+
+GRAPH_TEMPLATE
+std::vector<GRAPH_EDGE_TYPE>
+GRAPH_TYPE::bidirectionalShortestPath(i32 start_node, i32 end_node,
+                                      const Graph &R) const {
+    ShortestPathWorkspace<is_weighted> ws;
+    return bidirectionalShortestPath(start_node, end_node, R, ws);
+}
+
+GRAPH_TEMPLATE
+std::vector<GRAPH_EDGE_TYPE>
+GRAPH_TYPE::bidirectionalShortestPath(i32 start_node, i32 end_node) const {
+    if constexpr (is_directed) {
+        return bidirectionalShortestPath(start_node, end_node, rev());
+    } else {
+        return bidirectionalShortestPath(start_node, end_node, *this);
     }
-    return {route.rbegin(), route.rend()};
 }
 
-// O(N^3)
 GRAPH_TEMPLATE
-Matrix<GRAPH_COST_TYPE> GRAPH_TYPE::distancesFromAllNodes(Cost invalid) const {
-    auto mt(toMatrix(CMAX));
+void GRAPH_TYPE::distancesFromAllNodes(std::vector<Cost> &table, Cost invalid,
+                                       i32 num_threads) const {
+    // 未到達を INF で表す。d[i][j] <= INF が常に成り立つので和は溢れない
+    constexpr Cost INF = CMAX / 4;
+    table.assign((i64)N * N, INF);
+    for (i32 i = 0; i < N; ++i)
+        table[(i64)i * N + i] = 0;
+    for (auto &e : E) {
+        chmin(table[(i64)e->v0 * N + e->v1], e->cost);
+        if constexpr (!is_directed) {
+            chmin(table[(i64)e->v1 * N + e->v0], e->cost);
+        }
+    }
 
-    for (i32 k = 0; k < N; k++)         // 経由する頂点
-        for (i32 i = 0; i < N; i++)     // 始点
-            for (i32 j = 0; j < N; j++) // 終点
-                if (mt[i][k] != CMAX && mt[k][j] != CMAX)
-                    mt[i][j] = std::min(mt[i][j], mt[i][k] + mt[k][j]);
+    internal::blockedFloydWarshall(table.data(), N, num_threads);
 
+    for (auto &x : table)
+        if (x > INF / 2)
+            x = invalid;
+}
+
+GRAPH_TEMPLATE
+Matrix<GRAPH_COST_TYPE>
+GRAPH_TYPE::distancesFromAllNodes(Cost invalid, i32 num_threads) const {
+    std::vector<Cost> table;
+    distancesFromAllNodes(table, invalid, num_threads);
+    Matrix<Cost> mt(N, N);
     for (i32 i = 0; i < N; ++i)
         for (i32 j = 0; j < N; ++j)
-            if (mt[i][j] == CMAX)
-                mt[i][j] = invalid;
+            mt[i][j] = table[(i64)i * N + j];
     return mt;
 }
 
+GRAPH_TEMPLATE
+bool GRAPH_TYPE::distancesFromAllNodesSparse(std::vector<Cost> &table,
+                                             Cost invalid,
+                                             i32 num_threads) const {
+    auto adj = [&](i32 cu, auto &&f) {
+        for (auto &e : G[cu])
+            f(e->dst(cu), e->cost, e.get());
+    };
+    table.resize((i64)N * N);
+    return internal::allPairsDijkstra<is_weighted>(N, adj, table.data(),
+                                                   invalid, num_threads);
+}
+
+GRAPH_TEMPLATE
+std::vector<GRAPH_COST_TYPE>
+GRAPH_TYPE::distances(i32 start_node, Cost invalid, i32 num_threads) const {
+    static_assert(!is_weighted);
+    // 隣接を CSR 形式に詰め直す。無向なら逆方向も同じ
+    std::vector<i32> ofs(N + 1, 0), to, rofs, rto;
+    for (i32 v = 0; v < N; ++v)
+        ofs[v + 1] = ofs[v] + G[v].size();
+    to.reserve(ofs[N]);
+    for (i32 v = 0; v < N; ++v)
+        for (auto &e : G[v])
+            to.push_back(e->dst(v));
+    if constexpr (is_directed) {
+        rofs.assign(N + 1, 0);
+        for (auto &e : E)
+            ++rofs[e->v1 + 1];
+        for (i32 v = 0; v < N; ++v)
+            rofs[v + 1] += rofs[v];
+        rto.resize(E.size());
+        std::vector<i32> pos(rofs.begin(), rofs.end() - 1);
+        for (auto &e : E)
+            rto[pos[e->v1]++] = e->v0;
+    }
+    auto dist = internal::directionOptimizingBfs(
+        ofs, to, is_directed ? rofs : ofs, is_directed ? rto : to,
+        {start_node}, num_threads);
+    for (auto &d : dist)
+        if (d == -1)
+            d = invalid;
+    return dist;
+}
+
 } // namespace gandalfr
@@ -0,0 +1,38 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "../types.hpp"
+
+namespace gandalfr {
+
+/**
+ * @brief f(0), f(1), ..., f(n - 1) を num_threads 本のスレッドで分担して呼ぶ
+ * @details タスクは早い者勝ちで取り出す。num_threads <= 1 なら呼び出し元の
+ * スレッドで順に呼ぶ
+ * @attention 異なる i に対する f(i) は並行に呼ばれてよいこと
+ */
+template <class F> void parallelFor(i32 n, i32 num_threads, F &&f) {
+    num_threads = std::min(num_threads, n);
+    if (num_threads <= 1) {
+        for (i32 i = 0; i < n; ++i)
+            f(i);
+        return;
+    }
+    std::atomic<i32> next(0);
+    auto worker = [&] {
+        for (i32 i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n;)
+            f(i);
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (i32 t = 0; t < num_threads - 1; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &th : threads)
+        th.join();
+}
+
+} // namespace gandalfr
@@ -1,10 +1,14 @@
 #define PROBLEM "https://onlinejudge.u-aizu.ac.jp/problems/ITP1_1_A"
 
 #include <algorithm>
+#include <numeric>
 
 #include "testenv.hpp"
 #include "gandalfr/other/RandomUtility.hpp"
 #include "gandalfr/data_structure/BinaryTrie.hpp"
+#include "gandalfr/data_structure/ConcurrentUnionFind.hpp"
+#include "gandalfr/data_structure/UnionFind.hpp"
+#include "gandalfr/other/parallel.hpp"
 
 using namespace std;
 using namespace gandalfr;
@@ -55,6 +59,33 @@ TEST(DATA_STRUCTURE, BINARY_TRIE) {
     }
 }
 
+TEST(DATA_STRUCTURE, CONCURRENT_UNION_FIND) {
+    rep(iter, 0, 20) {
+        i32 N = RandUtil::randInt(1, 5000), M = RandUtil::randInt(0, 5000);
+        std::vector<std::pair<i32, i32>> E(M);
+        for (auto &[a, b] : E)
+            a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+
+        UnionFind uf(N);
+        for (auto [a, b] : E)
+            uf.unite(a, b);
+        ConcurrentUnionFind cuf(N);
+        std::vector<i32> merged(M, 0);
+        parallelFor(M, 4, [&](i32 i) {
+            merged[i] = cuf.unite(E[i].first, E[i].second);
+            // 併合済みの 2 点は同じグループに見える
+            assert(cuf.isSame(E[i].first, E[i].second));
+        });
+        EQ(cuf.numGroups(), uf.numGroups());
+        EQ(N - std::accumulate(all(merged), 0), uf.numGroups());
+        rep(i, 0, 1000) {
+            i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+            EQ(cuf.isSame(a, b), uf.isSame(a, b));
+        }
+        rep(v, 0, N) EQ(cuf.isSame(v, uf.leader(v)), true);
+    }
+}
+
 int main() {
     RunAllTests<false>();
     return 0;
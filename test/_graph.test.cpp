@@ -1,12 +1,28 @@
 #define PROBLEM "https://onlinejudge.u-aizu.ac.jp/problems/ITP1_1_A"
 
+#include <array>
+#include <numeric>
 #include <queue>
+#include <tuple>
 
 #include "testenv.hpp"
 #include "gandalfr/other/io.hpp"
+#include "gandalfr/graph/CentroidDecomposition.hpp"
 #include "gandalfr/graph/Lca.hpp"
 #include "gandalfr/graph/lowlink.hpp"
 #include "gandalfr/graph/auxiliaryTree.hpp"
+#include "gandalfr/graph/discomponent.hpp"
+#include "gandalfr/graph/BipartiteMatching.hpp"
+#include "gandalfr/graph/BoundedFlowGraph.hpp"
+#include "gandalfr/graph/CsrGraph.hpp"
+#include "gandalfr/graph/FlowGraph.hpp"
+#include "gandalfr/graph/GraphBuilder.hpp"
+#include "gandalfr/graph/Hld.hpp"
+#include "gandalfr/graph/TreePathQuery.hpp"
+#include "gandalfr/graph/gomoryHu.hpp"
+#include "gandalfr/graph/mst.hpp"
+#include "gandalfr/graph/scc.hpp"
+#include "gandalfr/other/RandomUtility.hpp"
 
 using namespace gandalfr;
 
@@ -94,6 +110,1122 @@ TEST(GRAPH, AUXILIARY_TREE) {
 
 }
 
+TEST(GRAPH, CSR) {
+    const i32 N = 200, M = 600;
+    Graph<WEIGHTED, UNDIRECTED> G(N, M);
+    Graph<UNWEIGHTED, DIRECTED> D(N, M);
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+        G.addEdge(a, b, RandUtil::randInt(1, 100));
+        D.addEdge(a, b);
+    }
+    CsrGraph CG(G);
+    CsrGraph CD(D);
+
+    rep(s, 0, 10) {
+        EQ(CG.distances(s, -1), G.distances(s, -1));
+        EQ(CD.distances(s, -1), D.distances(s, -1));
+        EQ(CG.preorder(s), G.preorder(s));
+        EQ(CG.inorder(s), G.inorder(s));
+        EQ(CD.postorder(s), D.postorder(s));
+        i64 len = 0;
+        for (auto &e : CG.shortestPath(s, N - 1)) len += e.cost;
+        EQ(len, G.distances(s, -1)[N - 1]);
+        EQ(CD.shortestPath(s, N - 1).size(), D.shortestPath(s, N - 1).size());
+    }
+    EQ(std::get<1>(CD.scc()), std::get<1>(D.scc()));
+    EQ(CG.mst().weight(), G.mst().weight());
+    EQ(CG.articulationPoints(), G.articulationPoints());
+    EQ(CG.bridges().size(), G.bridges().size());
+}
+
+TEST(GRAPH, GRAPH_BUILDER) {
+    const i32 N = 100, M = 300;
+    Graph<WEIGHTED, UNDIRECTED> G(N, M);
+    GraphBuilder<WEIGHTED, UNDIRECTED> B(N, M);
+    std::stringstream ss;
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+        i64 c = RandUtil::randInt(1, 100);
+        G.addEdge(a, b, c);
+        if (i < M / 2) {
+            B.addEdge(a, b, c);
+        } else {
+            ss << a + 1 << ' ' << b + 1 << ' ' << c << '\n';
+        }
+    }
+    B.readEdges(ss, M - M / 2, 1);
+
+    auto H = B.build();
+    EQ(H.numEdges(), G.numEdges());
+    EQ(H.weight(), G.weight());
+    rep(i, 0, N) {
+        EQ(H[i].size(), G[i].size());
+        rep(j, 0, G[i].size()) EQ(H[i][j]->id, G[i][j]->id);
+    }
+    EQ(H.distances(0, -1), G.distances(0, -1));
+    EQ(B.buildCsr().distances(0, -1), G.distances(0, -1));
+}
+
+TEST(GRAPH, HEAP_POLICY) {
+    const i32 N = 300, M = 1500;
+    for (i64 max_cost : {1LL, 30LL, 1000000000LL}) {
+        Graph<WEIGHTED, DIRECTED> G(N, M);
+        rep(i, 0, M) {
+            G.addEdge(RandUtil::randInt(0, N - 1), RandUtil::randInt(0, N - 1),
+                      RandUtil::randInt(0, max_cost));
+        }
+        rep(s, 0, 5) {
+            auto expected = G.distances(s, -1);
+            EQ(G.distances<HeapPolicy::RADIX>(s, -1), expected);
+            if (max_cost <= 1000)
+                EQ(G.distances<HeapPolicy::BUCKET>(s, -1), expected);
+            EQ(G.distances<HeapPolicy::AUTO>(s, -1), expected);
+            EQ(CsrGraph(G).distances<HeapPolicy::AUTO>(s, -1), expected);
+            i64 len = 0;
+            for (auto &e : G.shortestPath<HeapPolicy::AUTO>(s, N - 1))
+                len += e.cost;
+            EQ(len, std::max<i64>(expected[N - 1], 0));
+        }
+    }
+
+    // 辺を足すとコストの範囲が更新され、AUTO の選ぶキューも変わる
+    Graph<WEIGHTED, DIRECTED> H(3);
+    H.addEdge(0, 1, 5);
+    EQ(H.distances<HeapPolicy::AUTO>(0, -1), std::vector<i64>({0, 5, -1}));
+    H.addEdge(1, 2, 1000000000);
+    EQ(H.distances<HeapPolicy::AUTO>(0, -1),
+       std::vector<i64>({0, 5, 1000000005}));
+    H.addEdge(0, 2, -3);
+    EQ(H.distances<HeapPolicy::AUTO>(0, -1), std::vector<i64>({0, 5, -3}));
+    Graph<WEIGHTED, DIRECTED> H2 = H;
+    EQ(CsrGraph(H2).distances<HeapPolicy::AUTO>(0, -1),
+       std::vector<i64>({0, 5, -3}));
+}
+
+TEST(GRAPH, MULTI_SOURCE_DISTANCES) {
+    const i32 N = 200, M = 800;
+    Graph<WEIGHTED, UNDIRECTED> G(N + 1, M);
+    Graph<UNWEIGHTED, DIRECTED> D(N, M);
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+        G.addEdge(a, b, RandUtil::randInt(0, 50));
+        D.addEdge(a, b);
+    }
+    std::vector<std::pair<i32, i64>> src;
+    rep(i, 0, 5) src.emplace_back(RandUtil::randInt(0, N - 1), i * 10);
+    Graph<WEIGHTED, UNDIRECTED> H(G); // 超頂点 N からの単一始点と比較
+    for (auto [v, d] : src) H.addEdge(N, v, d);
+    auto expected = H.distances(N, -1);
+    expected.pop_back();
+    expected.push_back(-1);
+
+    for (auto policy_dist : {G.distances(src, -1),
+                             G.distances<HeapPolicy::RADIX>(src, -1),
+                             G.distances<HeapPolicy::BUCKET>(src, -1)}) {
+        EQ(policy_dist, expected);
+    }
+
+    i64 bound = 60;
+    auto bounded = G.distances<HeapPolicy::AUTO>(src, -1, {}, bound);
+    rep(i, 0, N + 1) EQ(bounded[i], (expected[i] <= bound ? expected[i] : -1));
+
+    std::vector<i32> targets{3, 7, 11};
+    auto early = G.distances(src, -1, targets);
+    for (i32 t : targets) EQ(early[t], expected[t]);
+    rep(i, 0, N + 1) if (early[i] != -1) EQ(early[i], expected[i]);
+
+    std::vector<std::pair<i32, i32>> usrc{{0, 2}, {5, 0}, {9, 1}};
+    Graph<UNWEIGHTED, DIRECTED> DH(N + 3, M);
+    for (auto &e : D.getAllEdges()) DH.addEdge(e->v0, e->v1);
+    DH.addEdge(N + 2, N + 1), DH.addEdge(N + 1, N), DH.addEdge(N, 0);
+    DH.addEdge(N + 2, 5), DH.addEdge(N + 1, 9);
+    auto uexp = DH.distances(N + 2, -1); // 初期距離 + 1 になる
+    auto ures = D.distances(usrc, -1, {}, 4);
+    rep(i, 0, N) {
+        EQ(ures[i], (uexp[i] != -1 && uexp[i] - 1 <= 4 ? uexp[i] - 1 : -1));
+    }
+}
+
+TEST(GRAPH, BIDIRECTIONAL_SEARCH) {
+    const i32 N = 300, M = 700;
+    Graph<WEIGHTED, DIRECTED> G(N, M);
+    Graph<UNWEIGHTED, UNDIRECTED> U(N, M);
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+        G.addEdge(a, b, RandUtil::randInt(0, 100));
+        U.addEdge(a, b);
+    }
+    auto R = G.rev();
+    CsrGraph CG(G), CR(R);
+    auto check = [&](auto &H, auto &path, i32 s, i32 t) {
+        i64 len = 0;
+        i32 cu = s;
+        for (auto &e : path) {
+            auto &org = *H.getEdge(e.id);
+            EQ(e.v0, cu);
+            if (&H == (void *)&G) {
+                EQ(std::make_pair(e.v0, e.v1), std::make_pair(org.v0, org.v1));
+            } else {
+                EQ(std::minmax(e.v0, e.v1), std::minmax(org.v0, org.v1));
+            }
+            cu = e.v1;
+            len += e.cost;
+        }
+        if (!path.empty()) EQ(cu, t);
+        return len;
+    };
+    rep(q, 0, 50) {
+        i32 s = RandUtil::randInt(0, N - 1), t = RandUtil::randInt(0, N - 1);
+        auto gd = G.distances(s, -1)[t];
+        auto gp = G.bidirectionalShortestPath(s, t, R);
+        EQ((gp.empty() && s != t ? -1 : check(G, gp, s, t)), gd);
+        auto cp = CG.bidirectionalShortestPath(s, t, CR);
+        EQ((cp.empty() && s != t ? -1 : check(G, cp, s, t)), gd);
+        auto ud = U.distances(s, -1)[t];
+        auto up = U.bidirectionalShortestPath(s, t);
+        EQ((up.empty() && s != t ? -1 : check(U, up, s, t)), ud);
+    }
+}
+
+TEST(GRAPH, SHORTEST_PATH_WORKSPACE) {
+    const i32 N = 200, M = 600;
+    Graph<WEIGHTED, DIRECTED> G(N, M);
+    rep(i, 0, M) {
+        G.addEdge(RandUtil::randInt(0, N - 1), RandUtil::randInt(0, N - 1),
+                  RandUtil::randInt(0, 20));
+    }
+    auto R = G.rev();
+    CsrGraph C(G);
+    ShortestPathWorkspace<WEIGHTED> ws;
+    rep(q, 0, 100) {
+        i32 s = RandUtil::randInt(0, N - 1), t = RandUtil::randInt(0, N - 1);
+        auto expected = G.distances(s, -1);
+        G.distances<HeapPolicy::AUTO>(ws, {{s, 0}});
+        rep(i, 0, N) EQ((ws.reached(i) ? ws.dist(i) : -1), expected[i]);
+        i64 bound = 15;
+        for (i32 v : C.distances<HeapPolicy::RADIX>(ws, {{s, 0}}, {}, bound)) {
+            EQ(ws.dist(v), expected[v]);
+        }
+        rep(i, 0, N) EQ(ws.reached(i), (expected[i] != -1 && expected[i] <= bound));
+
+        auto path = G.shortestPath(s, t, ws);
+        auto bipath = G.bidirectionalShortestPath(s, t, R, ws);
+        i64 len = 0, bilen = 0;
+        for (auto &e : path) len += e.cost;
+        for (auto &e : bipath) bilen += e.cost;
+        EQ(len, std::max<i64>(expected[t], 0));
+        EQ(bilen, len);
+    }
+
+    // 重みなしの多始点は、初期距離が整列していなくてもよい
+    Graph<UNWEIGHTED, DIRECTED> U(N, M);
+    for (auto &e : G.getAllEdges()) U.addEdge(e->v0, e->v1);
+    ShortestPathWorkspace<UNWEIGHTED> uws;
+    rep(q, 0, 20) {
+        std::vector<std::pair<i32, i32>> src;
+        rep(k, 0, 4) src.emplace_back(RandUtil::randInt(0, N - 1),
+                                      RandUtil::randInt(0, 5));
+        std::vector<i32> expected(N, -1);
+        for (auto [v, d0] : src) {
+            auto d = U.distances(v, -1);
+            rep(i, 0, N) if (d[i] != -1 && (expected[i] == -1 ||
+                                            d[i] + d0 < expected[i]))
+                expected[i] = d[i] + d0;
+        }
+        U.distances(uws, src);
+        rep(i, 0, N) EQ((uws.reached(i) ? uws.dist(i) : -1), expected[i]);
+    }
+}
+
+TEST(GRAPH, FLOYD_WARSHALL) {
+    const i32 N = 150, M = 1000;
+    Graph<WEIGHTED, DIRECTED> G(N, M);
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 2);
+        i32 b = RandUtil::randInt(a + 1, N - 1); // DAG なので負辺でもよい
+        G.addEdge(a, b, RandUtil::randInt(-50, 100));
+    }
+    std::vector<std::vector<i64>> expected(N, std::vector<i64>(N, INFLL));
+    rep(i, 0, N) expected[i][i] = 0;
+    for (auto &e : G.getAllEdges()) chmin(expected[e->v0][e->v1], e->cost);
+    rep(k, 0, N) rep(i, 0, N) rep(j, 0, N) {
+        if (expected[i][k] != INFLL && expected[k][j] != INFLL)
+            chmin(expected[i][j], expected[i][k] + expected[k][j]);
+    }
+    for (i32 th : {1, 4}) {
+        auto mt = G.distancesFromAllNodes(INFLL, th);
+        rep(i, 0, N) rep(j, 0, N) EQ(mt[i][j], expected[i][j]);
+    }
+}
+
+TEST(GRAPH, SPARSE_ALL_PAIRS) {
+    const i32 N = 120, M = 600;
+    Graph<WEIGHTED, DIRECTED> G(N, M);
+    rep(i, 0, M) {
+        i32 a = RandUtil::randInt(0, N - 2);
+        i32 b = RandUtil::randInt(a + 1, N - 1);
+        G.addEdge(a, b, RandUtil::randInt(-50, 100));
+    }
+    std::vector<i64> expected, table;
+    G.distancesFromAllNodes(expected, INFLL);
+    CsrGraph<WEIGHTED, DIRECTED> C(G);
+    for (i32 th : {1, 4}) {
+        EQ(G.distancesFromAllNodesSparse(table, INFLL, th), true);
+        EQ((table == expected), true);
+        EQ(C.distancesFromAllNodesSparse(table, INFLL, th), true);
+        EQ((table == expected), true);
+    }
+
+    // 負閉路
+    G.addEdge(0, N - 1, 0);
+    G.addEdge(N - 1, 0, -1);
+    EQ(G.distancesFromAllNodesSparse(table, INFLL), false);
+
+    Graph<UNWEIGHTED, UNDIRECTED> H(N);
+    rep(i, 0, N) H.addEdge(RandUtil::randInt(0, N - 1),
+                           RandUtil::randInt(0, N - 1));
+    std::vector<i32> expected2, table2;
+    H.distancesFromAllNodes(expected2, -1);
+    EQ(H.distancesFromAllNodesSparse(table2, -1, 3), true);
+    EQ((table2 == expected2), true);
+}
+
+TEST(GRAPH, DEEP_DFS) {
+    // 再帰だとスタックが溢れる深さ
+    const i32 N = 1000000;
+    Graph<UNWEIGHTED, UNDIRECTED> G(N, N - 1);
+    rep(i, 0, N - 1) G.addEdge(i, i + 1);
+
+    auto pre = G.preorder(0), post = G.postorder(0), in = G.inorder(0);
+    EQ((i32)pre.size(), N);
+    EQ((i32)post.size(), N);
+    EQ((i32)in.size(), 2 * N - 1);
+    rep(i, 0, N) {
+        EQ(pre[i], i);
+        EQ(post[i], N - 1 - i);
+    }
+    EQ((i32)G.bridges().size(), N - 1);
+    auto sep = G.articulationPoints();
+    EQ(sep[0], 0);
+    EQ(sep[N / 2], 1);
+
+    Graph<WEIGHTED, UNDIRECTED> T(N, N - 1);
+    rep(i, 0, N - 1) T.addEdge(i, i + 1, 1);
+    Hld<WEIGHTED, UNDIRECTED> hld(T, N / 2);
+    auto path = hld.path(0, N - 1);
+    i32 len = 0;
+    for (auto [l, r] : path) len += r - l;
+    EQ(len, N);
+}
+
+TEST(GRAPH, DIRECTION_OPTIMIZING_BFS) {
+    auto check = [](auto G) {
+        CsrGraph C(G);
+        i32 s = RandUtil::randInt(0, G.numNodes() - 1);
+        auto expected = G.distances(s, -1);
+        for (i32 th : {1, 4}) {
+            EQ((G.distances(s, -1, th) == expected), true);
+            EQ((C.distances(s, -1, th) == expected), true);
+        }
+    };
+    for (auto [N, M] : {std::pair{1, 0}, {100, 50}, {3000, 60000},
+                        {20000, 30000}}) {
+        Graph<UNWEIGHTED, UNDIRECTED> U(N, M);
+        Graph<UNWEIGHTED, DIRECTED> D(N, M);
+        rep(i, 0, M) {
+            U.addEdge(RandUtil::randInt(0, N - 1), RandUtil::randInt(0, N - 1));
+            D.addEdge(RandUtil::randInt(0, N - 1), RandUtil::randInt(0, N - 1));
+        }
+        check(U);
+        check(D);
+    }
+}
+
+// 各辺の流量が容量制約と流量保存を満たし、s から flow だけ出ているか
+void checkFlow(const FlowGraph &G, i32 s, i32 t, i64 flow) {
+    std::vector<i64> excess(G.numNodes(), 0);
+    for (auto &e : G.getAllEdges()) {
+        EQ((0 <= e->flow() && e->flow() <= e->capacity()), true);
+        excess[e->v0] -= e->flow();
+        excess[e->v1] += e->flow();
+    }
+    rep(v, 0, G.numNodes())
+        EQ(excess[v], (v == s ? -flow : v == t ? flow : 0));
+}
+
+// 森 G を root から素朴に BFS して {親, 深さ, 根からの距離} を求める
+// root と連結でないノードは、親が -1、深さと距離が -1 になる
+template <bool is_weighted>
+std::tuple<std::vector<i32>, std::vector<i32>, std::vector<i64>>
+naiveTree(const Graph<is_weighted, UNDIRECTED> &G, i32 root) {
+    const i32 N = G.numNodes();
+    std::vector<i32> par(N, -1), dep(N, -1), que = {root};
+    std::vector<i64> dist(N, -1);
+    dep[root] = 0, dist[root] = 0;
+    rep(qh, 0, que.size()) for (auto &e : G[que[qh]]) {
+        i32 v = que[qh], w = e->dst(v);
+        if (dep[w] != -1)
+            continue;
+        par[w] = v, dep[w] = dep[v] + 1, dist[w] = dist[v] + e->cost;
+        que.push_back(w);
+    }
+    return {par, dep, dist};
+}
+
+TEST(GRAPH, DINIC) {
+    rep(iter, 0, 100) {
+        i32 N = RandUtil::randInt(2, 30), M = RandUtil::randInt(0, 100);
+        FlowGraph G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 20));
+        FlowGraph H(G);
+        i64 flow = G.dinic(0, N - 1);
+        EQ(flow, H.fordFulkerson(0, N - 1));
+        checkFlow(G, 0, N - 1, flow);
+        // 流した後の残余グラフには増加路がない
+        EQ(G.dinic(0, N - 1), 0);
+    }
+
+    // 二部マッチング
+    const i32 L = 300, R = 300;
+    FlowGraph B(L + R + 2);
+    rep(i, 0, L) B.addEdge(L + R, i, 1);
+    rep(i, 0, R) B.addEdge(L + i, L + R + 1, 1);
+    rep(i, 0, L) rep(j, 0, 5) B.addEdge(i, L + RandUtil::randInt(0, R - 1), 1);
+    FlowGraph B2(B);
+    EQ(B.dinic(L + R, L + R + 1), B2.fordFulkerson(L + R, L + R + 1));
+
+    // 流量の上限
+    ResidualGraph P(3);
+    P.addEdge(0, 1, 10);
+    P.addEdge(1, 2, 10);
+    EQ(P.dinic(0, 2, 4), 4);
+    EQ(P.flow(0), 4);
+    EQ(P.dinic(0, 2), 6);
+}
+
+TEST(GRAPH, PUSH_RELABEL) {
+    rep(iter, 0, 200) {
+        i32 N = RandUtil::randInt(2, 40), M = RandUtil::randInt(0, 200);
+        FlowGraph G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 20));
+        FlowGraph H(G);
+        i32 s = RandUtil::randInt(0, N - 1), t = RandUtil::randInt(0, N - 2);
+        if (t >= s) ++t;
+        i64 flow = G.maxFlow(s, t, MaxFlowAlgorithm::PUSH_RELABEL);
+        EQ(flow, H.maxFlow(s, t, MaxFlowAlgorithm::DINIC));
+        checkFlow(G, s, t, flow);
+        EQ(G.maxFlow(s, t, MaxFlowAlgorithm::PUSH_RELABEL), 0);
+    }
+}
+
+TEST(GRAPH, MIN_COST_SLOPE) {
+    rep(iter, 0, 100) {
+        i32 N = RandUtil::randInt(2, 20), M = RandUtil::randInt(0, 60);
+        bool dag = iter % 2;
+        FlowGraph G(N, M);
+        rep(i, 0, M) {
+            i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+            // 負のコストを使うときは負閉路ができないよう DAG にする
+            if (dag && a == b) continue;
+            if (dag && a > b) std::swap(a, b);
+            G.addEdge(a, b, RandUtil::randInt(0, 10),
+                      RandUtil::randInt(dag ? -10 : 0, 10));
+        }
+        FlowGraph H(G), K(G);
+        auto slope = G.minCostSlope(0, N - 1);
+        auto [flow, cost] = slope.back();
+        EQ(flow, H.dinic(0, N - 1));
+        checkFlow(G, 0, N - 1, flow);
+
+        // ポテンシャルが最適性を保証する
+        auto &p = G.potentials();
+        i64 sum = 0;
+        for (auto &e : G.getAllEdges()) {
+            sum += e->cost * e->flow();
+            if (e->flow() < e->capacity())
+                EQ((e->cost + p[e->v0] - p[e->v1] >= 0), true);
+            if (e->flow() > 0)
+                EQ((-e->cost + p[e->v1] - p[e->v0] >= 0), true);
+        }
+        EQ(sum, cost);
+
+        // 傾きは単調増加で、途中の流量も折れ線上にある
+        rep(i, 2, (i32)slope.size()) {
+            auto [f0, c0] = slope[i - 2];
+            auto [f1, c1] = slope[i - 1];
+            auto [f2, c2] = slope[i];
+            EQ(((c1 - c0) * (f2 - f1) < (c2 - c1) * (f1 - f0)), true);
+        }
+        i64 F = RandUtil::randInt(1, flow + 1);
+        if (F <= flow) {
+            i32 k = 1;
+            while (slope[k].first < F) ++k;
+            auto [f0, c0] = slope[k - 1];
+            auto [f1, c1] = slope[k];
+            EQ(K.primalDual(0, N - 1, F),
+               c0 + (c1 - c0) / (f1 - f0) * (F - f0));
+        }
+        EQ(FlowGraph(H).primalDual(0, N - 1, flow + 1), -1);
+    }
+}
+
+// 残余グラフに負閉路がないか (最小費用循環流であるための必要十分条件)
+bool noNegativeCycle(const FlowGraph &G) {
+    i32 N = G.numNodes();
+    std::vector<i64> d(N, 0);
+    rep(iter, 0, N + 1) {
+        bool updated = false;
+        for (auto &e : G.getAllEdges()) {
+            if (e->flow() < e->capacity())
+                updated |= chmin(d[e->v1], d[e->v0] + e->cost);
+            if (e->flow() > 0)
+                updated |= chmin(d[e->v0], d[e->v1] - e->cost);
+        }
+        if (!updated) return true;
+    }
+    return false;
+}
+
+TEST(GRAPH, COST_SCALING) {
+    rep(iter, 0, 100) {
+        i32 N = RandUtil::randInt(2, 20), M = RandUtil::randInt(0, 80);
+        FlowGraph G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 10),
+                               RandUtil::randInt(0, 1000000));
+        FlowGraph H(G), K(G);
+        i64 F = RandUtil::randInt(0, H.dinic(0, N - 1) + 1);
+        i64 expected = G.primalDual(0, N - 1, F);
+        EQ(K.minCostFlow(0, N - 1, F, MinCostFlowAlgorithm::COST_SCALING),
+           expected);
+        if (expected != -1) {
+            checkFlow(K, 0, N - 1, F);
+            EQ(noNegativeCycle(K), true);
+        }
+    }
+
+    // 負閉路を含むグラフの最小費用循環流
+    rep(iter, 0, 100) {
+        i32 N = RandUtil::randInt(1, 15), M = RandUtil::randInt(0, 60);
+        FlowGraph G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 10),
+                               RandUtil::randInt(-100, 100));
+        i64 cost = G.minCostCirculation();
+        EQ(cost, G.totalCost());
+        checkFlow(G, 0, 0, 0);
+        EQ(noNegativeCycle(G), true);
+    }
+}
+
+TEST(GRAPH, INCREMENTAL_FLOW) {
+    rep(iter, 0, 50) {
+        i32 N = RandUtil::randInt(2, 20), M = RandUtil::randInt(1, 80);
+        i32 s = 0, t = N - 1;
+        ResidualGraph R(N, M);
+        rep(i, 0, M) R.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 10));
+        i64 flow = R.dinic(s, t);
+        rep(q, 0, 30) {
+            i32 i = RandUtil::randInt(0, M - 1);
+            flow -= R.changeCapacity(i, RandUtil::randInt(0, 10), s, t);
+            EQ(R.flowValue(s), flow);
+            // 容量制約と流量保存
+            std::vector<i64> excess(N, 0);
+            rep(j, 0, M) {
+                EQ((0 <= R.flow(j) && R.flow(j) <= R.capacity(j)), true);
+                excess[R.edgeFrom(j)] -= R.flow(j);
+                excess[R.edgeTo(j)] += R.flow(j);
+            }
+            rep(v, 1, N - 1) EQ(excess[v], 0);
+
+            flow += R.dinic(s, t);
+            ResidualGraph F(N, M);
+            rep(j, 0, M) F.addEdge(R.edgeFrom(j), R.edgeTo(j), R.capacity(j));
+            EQ(flow, F.dinic(s, t));
+        }
+        R.resetFlow();
+        EQ(R.flowValue(s), 0);
+        EQ(R.dinic(s, t), flow);
+
+        // 最大でない流れのまま続けて変更しても、流量は増えない
+        R.resetFlow();
+        flow = R.dinic(s, t, RandUtil::randInt(0, 15));
+        rep(q, 0, 30) {
+            i32 i = RandUtil::randInt(0, M - 1);
+            i64 dec = R.changeCapacity(i, RandUtil::randInt(0, 10), s, t);
+            EQ((dec >= 0), true);
+            flow -= dec;
+            EQ(R.flowValue(s), flow);
+            std::vector<i64> excess(N, 0);
+            rep(j, 0, M) {
+                EQ((0 <= R.flow(j) && R.flow(j) <= R.capacity(j)), true);
+                excess[R.edgeFrom(j)] -= R.flow(j);
+                excess[R.edgeTo(j)] += R.flow(j);
+            }
+            rep(v, 1, N - 1) EQ(excess[v], 0);
+        }
+    }
+
+    // 2 -> 0 の超過を 2 -> 3 に流すと、流量が 0 から 1 に増えてしまう
+    ResidualGraph R(4, 3);
+    R.addEdge(2, 0, 2);
+    R.addEdge(2, 3, 2);
+    R.addEdge(0, 2, 2);
+    EQ(R.dinic(0, 3), 2);
+    EQ(R.changeCapacity(1, 0, 0, 3), 2);
+    EQ(R.changeCapacity(1, 2, 0, 3), 0);
+    EQ(R.changeCapacity(0, 1, 0, 3), 0);
+    EQ(R.flowValue(0), 0);
+    EQ(R.flow(0), 1);
+    EQ(R.flow(2), 1);
+
+    FlowGraph G(4);
+    G.addEdge(0, 1, 5);
+    G.addEdge(1, 3, 5);
+    G.addEdge(0, 2, 3);
+    G.addEdge(2, 3, 3);
+    G.addEdge(1, 2, 5);
+    EQ(G.dinic(0, 3), 8);
+    // 2 -> 3 は飽和しているので 1 の超過は s に戻る
+    EQ(G.changeCapacity(1, 2, 0, 3), 3);
+    checkFlow(G, 0, 3, 5);
+    EQ(G.changeCapacity(3, 1, 0, 3), 2);
+    checkFlow(G, 0, 3, 3);
+    EQ(G.changeCapacity(3, 4, 0, 3), 0);
+    EQ(G.dinic(0, 3), 3);
+    G.resetFlow();
+    EQ(G.dinic(0, 3), 6);
+}
+
+TEST(GRAPH, MIN_CUT) {
+    rep(iter, 0, 100) {
+        i32 N = RandUtil::randInt(2, 20), M = RandUtil::randInt(0, 60);
+        FlowGraph G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 10));
+        FlowGraph H(G);
+        auto [value, side, cut] = G.minCut(0, N - 1);
+        EQ(value, H.dinic(0, N - 1));
+        EQ(side[0], true);
+        EQ(side[N - 1], false);
+        // カットの辺は飽和し、t 側から s 側への辺は流れていない
+        rep(i, 0, M) {
+            auto &e = G.getEdge(i);
+            bool in_cut = side[e->v0] && !side[e->v1];
+            EQ(in_cut, (std::find(cut.begin(), cut.end(), i) != cut.end()));
+            if (in_cut)
+                EQ(e->flow(), e->capacity());
+            if (!side[e->v0] && side[e->v1])
+                EQ(e->flow(), 0);
+        }
+    }
+}
+
+TEST(GRAPH, GOMORY_HU) {
+    rep(iter, 0, 30) {
+        i32 N = RandUtil::randInt(1, 15), M = RandUtil::randInt(0, 40);
+        Graph<WEIGHTED, UNDIRECTED> G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, 10));
+        auto T = G.gomoryHuTree();
+        EQ(T.numEdges(), N - 1);
+        auto T3 = G.gomoryHuTree(3);
+        rep(i, 0, N - 1) {
+            EQ(T3.getEdge(i)->v1, T.getEdge(i)->v1);
+            EQ(T3.getEdge(i)->cost, T.getEdge(i)->cost);
+        }
+        rep(s, 0, N) {
+            // 木の上で s からのパスの辺の最小値
+            std::vector<i64> mn(N, -1);
+            std::vector<i32> que = {(i32)s};
+            mn[s] = std::numeric_limits<i64>::max();
+            rep(qh, 0, que.size()) {
+                i32 v = que[qh];
+                for (auto &e : T[v]) {
+                    i32 w = e->dst(v);
+                    if (mn[w] != -1)
+                        continue;
+                    mn[w] = std::min(mn[v], e->cost);
+                    que.push_back(w);
+                }
+            }
+            rep(t, s + 1, N) {
+                FlowGraph F(N, 2 * M);
+                for (auto &e : G.getAllEdges()) {
+                    F.addEdge(e->v0, e->v1, e->cost);
+                    F.addEdge(e->v1, e->v0, e->cost);
+                }
+                EQ(mn[t], F.dinic(s, t));
+            }
+        }
+    }
+}
+
+TEST(GRAPH, BIPARTITE_MATCHING) {
+    rep(iter, 0, 100) {
+        i32 L = RandUtil::randInt(0, 30), R = RandUtil::randInt(0, 150);
+        i32 M = (L && R ? RandUtil::randInt(0, L * R) : 0);
+        BipartiteMatching A(L, R);
+        FlowGraph F(L + R + 2);
+        rep(i, 0, L) F.addEdge(L + R, i, 1);
+        rep(i, 0, R) F.addEdge(L + i, L + R + 1, 1);
+        rep(i, 0, M) {
+            i32 u = RandUtil::randInt(0, L - 1), v = RandUtil::randInt(0, R - 1);
+            A.addEdge(u, v);
+            F.addEdge(u, L + v, 1);
+        }
+        BipartiteMatching B(A);
+        i32 size = A.hopcroftKarp();
+        EQ(size, F.dinic(L + R, L + R + 1));
+        EQ(B.hopcroftKarpDense(), size);
+
+        for (auto *X : {&A, &B}) {
+            auto match = X->matching();
+            EQ((i32)match.size(), size);
+            for (auto [u, v] : match) {
+                EQ(X->mateLeft(u), v);
+                EQ(X->mateRight(v), u);
+            }
+            // 被覆の大きさはマッチングと等しく、全ての辺を覆う
+            auto [cl, cr] = X->minVertexCover();
+            EQ((i32)(cl.size() + cr.size()), size);
+            std::vector<bool> in_l(L, false), in_r(R, false);
+            for (i32 u : cl)
+                in_l[u] = true;
+            for (i32 v : cr)
+                in_r[v] = true;
+            rep(u, 0, L) for (auto &e : F[u]) {
+                if (e->v0 == u && e->v1 < L + R)
+                    EQ((in_l[u] || in_r[e->v1 - L]), true);
+            }
+        }
+    }
+
+    Graph<UNWEIGHTED, UNDIRECTED> G(6);
+    G.addEdge(0, 3);
+    G.addEdge(0, 4);
+    G.addEdge(1, 3);
+    G.addEdge(2, 3);
+    G.addEdge(5, 4);
+    auto [mate, cover] = G.bipartiteMatching();
+    EQ((mate[3] != -1 && mate[4] != -1), true);
+    EQ(mate[mate[3]], 3);
+    EQ(mate[mate[4]], 4);
+    EQ((cover[3] && cover[4]), true);
+    auto [mate2, cover2] = G.bipartiteMatching(true);
+    EQ((mate2[3] != -1 && mate2[4] != -1), true);
+    EQ((cover2[3] && cover2[4]), true);
+}
+
+TEST(GRAPH, BOUNDED_FLOW) {
+    rep(iter, 0, 300) {
+        i32 N = RandUtil::randInt(2, 4), M = RandUtil::randInt(0, 5);
+        BoundedFlowGraph G(N);
+        std::vector<i32> from(M), to(M);
+        rep(i, 0, M) {
+            from[i] = RandUtil::randInt(0, N - 1);
+            to[i] = RandUtil::randInt(0, N - 1);
+            G.addEdge(from[i], to[i], 0, 0);
+        }
+        // 上下限と供給量を変えながら同じグラフで解き直す
+        rep(q, 0, 5) {
+            rep(i, 0, M) {
+                i64 l = RandUtil::randInt(0, 2), r = RandUtil::randInt(0, 3);
+                G.setBounds(i, std::min(l, r), std::max(l, r));
+            }
+            rep(v, 0, N) G.setSupply(v, 0);
+            G.setSupply(0, RandUtil::randInt(-2, 2));
+            G.setSupply(N - 1, RandUtil::randInt(-2, 2));
+
+            // 全ての流量の組を調べる
+            bool brute_ok = false;
+            i64 brute_max = -1;
+            std::vector<i64> f(M);
+            auto dfs = [&](auto self, i32 i) -> void {
+                if (i == M) {
+                    std::vector<i64> out(N, 0);
+                    rep(j, 0, M) out[from[j]] += f[j], out[to[j]] -= f[j];
+                    bool circ = true, st = true;
+                    rep(v, 0, N) {
+                        circ &= (out[v] == G.supply(v));
+                        if (v != 0 && v != N - 1)
+                            st &= (out[v] == G.supply(v));
+                    }
+                    brute_ok |= circ;
+                    i64 fs = out[0] - G.supply(0);
+                    i64 ft = out[N - 1] - G.supply(N - 1);
+                    if (st && fs == -ft)
+                        brute_max = std::max(brute_max, fs);
+                    return;
+                }
+                for (f[i] = G.lower(i); f[i] <= G.upper(i); ++f[i])
+                    self(self, i + 1);
+            };
+            dfs(dfs, 0);
+
+            auto check = [&](i32 s, i32 t, i64 value) {
+                std::vector<i64> out(N, 0);
+                rep(j, 0, M) {
+                    EQ((G.lower(j) <= G.flow(j) && G.flow(j) <= G.upper(j)),
+                       true);
+                    out[from[j]] += G.flow(j), out[to[j]] -= G.flow(j);
+                }
+                rep(v, 0, N) EQ(out[v], G.supply(v) + (v == s   ? value
+                                                       : v == t ? -value
+                                                                : 0));
+            };
+            EQ(G.feasible(), brute_ok);
+            if (brute_ok)
+                check(0, N - 1, 0);
+            i64 mx = G.maxFlow(0, N - 1);
+            EQ(mx, brute_max);
+            if (mx >= 0)
+                check(0, N - 1, mx);
+        }
+    }
+}
+
+TEST(GRAPH, MST_ALGORITHMS) {
+    rep(iter, 0, 40) {
+        i32 N = RandUtil::randInt(1, 3000), M = RandUtil::randInt(0, 20000);
+        i32 C = RandUtil::randInt(1, 100);
+        Graph<WEIGHTED, UNDIRECTED> G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(-C, C));
+        auto K = G.mst();
+        UnionFind uf(N);
+        for (auto &e : G.getAllEdges())
+            uf.unite(e->v0, e->v1);
+        EQ(K.numEdges(), N - uf.numGroups());
+        for (auto algo : {MstAlgorithm::FILTER_KRUSKAL, MstAlgorithm::BORUVKA})
+            for (i32 threads : {1, 3}) {
+                auto T = G.mst(algo, threads);
+                EQ(T.numEdges(), K.numEdges());
+                rep(i, 0, K.numEdges())
+                    EQ(T.getEdge(i)->id, K.getEdge(i)->id);
+            }
+    }
+}
+
+TEST(GRAPH, PARALLEL_DISCOMPONENT) {
+    rep(iter, 0, 20) {
+        i32 N = RandUtil::randInt(1, 3000), M = RandUtil::randInt(0, 3000);
+        Graph<UNWEIGHTED, UNDIRECTED> G(N, M);
+        rep(i, 0, M) G.addEdge(RandUtil::randInt(0, N - 1),
+                               RandUtil::randInt(0, N - 1));
+        auto uf = G.buildUnionFind(), uf4 = G.buildUnionFind(4);
+        EQ(uf4.numGroups(), uf.numGroups());
+        rep(v, 0, N) EQ(uf4.isSame(v, uf.leader(v)), true);
+        auto [Gs, grp, nd] = G.discomponent(4);
+        EQ((i32)Gs.size(), uf.numGroups());
+        rep(v, 0, N) EQ(Gs[grp[v]].numNodes(), uf.groupSize(v));
+        for (auto &e : G.getAllEdges())
+            EQ(grp[e->v0], grp[e->v1]);
+    }
+}
+
+TEST(GRAPH, LCA_RANDOM) {
+    rep(iter, 0, 30) {
+        i32 N = RandUtil::randInt(1, 2000), root = RandUtil::randInt(0, N - 1);
+        Graph<WEIGHTED, UNDIRECTED> G(N, N - 1);
+        rep(i, 1, N) G.addEdge(i, RandUtil::randInt(0, i - 1),
+                               RandUtil::randInt(0, 100));
+        Lca lca(G, root);
+        auto [par, dep, dist] = naiveTree(G, root);
+        rep(q, 0, 2000) {
+            i32 a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+            i32 x = a, y = b;
+            while (dep[x] > dep[y])
+                x = par[x];
+            while (dep[y] > dep[x])
+                y = par[y];
+            while (x != y)
+                x = par[x], y = par[y];
+            EQ(lca.getAncestor(a, b), x);
+            EQ(lca.distance(a, b), dist[a] + dist[b] - 2 * dist[x]);
+        }
+        std::vector<std::pair<i32, i32>> qs(RandUtil::randInt(0, 300));
+        for (auto &[a, b] : qs)
+            a = RandUtil::randInt(0, N - 1), b = RandUtil::randInt(0, N - 1);
+        for (i32 threads : {1, 3}) {
+            auto res = lca.batch(qs, threads);
+            EQ(res.size(), qs.size());
+            rep(i, 0, qs.size()) {
+                auto [a, b] = qs[i];
+                EQ(res[i].first, lca.getAncestor(a, b));
+                EQ(res[i].second, lca.distance(a, b));
+            }
+        }
+    }
+
+    // 深いパス
+    const i32 N = 1000000;
+    Graph<UNWEIGHTED, UNDIRECTED> P(N, N - 1);
+    rep(i, 1, N) P.addEdge(i - 1, i);
+    Lca lca(P, 0);
+    EQ(lca.getAncestor(N - 1, 12345), 12345);
+    EQ(lca.distance(N - 1, 0), N - 1);
+}
+
+TEST(GRAPH, HLD_QUERIES) {
+    rep(iter, 0, 30) {
+        i32 N = RandUtil::randInt(1, 500), root = RandUtil::randInt(0, N - 1);
+        Graph<WEIGHTED, UNDIRECTED> G(N, N - 1);
+        rep(i, 1, N) G.addEdge(RandUtil::randInt(0, i - 1), i,
+                               RandUtil::randInt(0, 100));
+        Hld hld(G, root);
+        auto [par, dep, dist] = naiveTree(G, root);
+        std::vector<i32> at(N);
+        rep(v, 0, N) at[hld.node(v).first] = v;
+        // 行きがけ順で親の直後に来る子が、最も大きい部分木を持つ
+        rep(v, 0, N) {
+            if (par[v] == -1)
+                continue;
+            auto [l, r] = hld.node(v);
+            auto [pl, pr] = hld.node(at[hld.node(par[v]).first + 1]);
+            EQ((r - l <= pr - pl), true);
+        }
+
+        rep(q, 0, 200) {
+            i32 u = RandUtil::randInt(0, N - 1), v = RandUtil::randInt(0, N - 1);
+            // u から v へのパス上のノードを素朴に並べる
+            std::vector<i32> up, down;
+            i32 x = u, y = v;
+            while (dep[x] > dep[y])
+                up.push_back(x), x = par[x];
+            while (dep[y] > dep[x])
+                down.push_back(y), y = par[y];
+            while (x != y)
+                up.push_back(x), down.push_back(y), x = par[x], y = par[y];
+            i32 w = x;
+            std::vector<i32> walk = up;
+            walk.push_back(w);
+            walk.insert(walk.end(), down.rbegin(), down.rend());
+
+            EQ(hld.lca(u, v), w);
+            EQ(hld.distance(u, v), dist[u] + dist[v] - 2 * dist[w]);
+            EQ(hld.depth(u), dep[u]);
+            rep(k, 0, walk.size() + 1) {
+                i32 expected = (k < (i32)walk.size() ? walk[k] : -1);
+                EQ(hld.kthOnPath(u, v, k), expected);
+            }
+            i32 k = RandUtil::randInt(0, dep[u] + 1);
+            i32 anc = u;
+            rep(j, 0, k) anc = (anc == -1 ? -1 : par[anc]);
+            EQ(hld.levelAncestor(u, k), anc);
+
+            for (bool edge : {false, true}) {
+                std::vector<i32> got;
+                hld.path(u, v, edge, [&](i32 l, i32 r, bool reversed) {
+                    EQ((l < r), true);
+                    if (reversed)
+                        for (i32 i = r - 1; i >= l; --i)
+                            got.push_back(at[i]);
+                    else
+                        for (i32 i = l; i < r; ++i)
+                            got.push_back(at[i]);
+                });
+                std::vector<i32> expected = walk;
+                if (edge)
+                    expected.erase(std::find(all(expected), w));
+                EQ(got, expected);
+            }
+        }
+    }
+}
+
+namespace tree_path_query {
+// 一次関数 x -> ax + b の合成 (左から順に適用する)
+using Affine = std::pair<i64, i64>;
+constexpr i64 MOD = 998244353;
+Affine affineOp(Affine f, Affine g) {
+    return {g.first * f.first % MOD, (g.first * f.second + g.second) % MOD};
+}
+Affine affineE() { return {1, 0}; }
+
+// 列の {先頭, 末尾, 最小値}。空なら最小値が i64MAX
+using Ends = std::array<i64, 3>;
+Ends endsOp(Ends a, Ends b) {
+    if (a[2] == i64MAX)
+        return b;
+    if (b[2] == i64MAX)
+        return a;
+    return {a[0], b[1], std::min(a[2], b[2])};
+}
+Ends endsE() { return {0, 0, i64MAX}; }
+Ends endsMapping(i64 f, Ends x) {
+    return (x[2] == i64MAX ? x : Ends{x[0] + f, x[1] + f, x[2] + f});
+}
+i64 addComposition(i64 f, i64 g) { return f + g; }
+i64 addId() { return 0; }
+} // namespace tree_path_query
+
+TEST(GRAPH, TREE_PATH_QUERY) {
+    using namespace tree_path_query;
+    rep(iter, 0, 30) {
+        i32 N = RandUtil::randInt(1, 300), root = RandUtil::randInt(0, N - 1);
+        bool edge = iter % 2;
+        Graph<UNWEIGHTED, UNDIRECTED> G(N, N - 1);
+        rep(i, 1, N) G.addEdge(RandUtil::randInt(0, i - 1), i);
+        auto [par, dep, dist] = naiveTree(G, root);
+        // u から v へのパス上で値を持つノード (辺なら子の側) を順に並べる
+        auto walk = [&](i32 u, i32 v) {
+            std::vector<i32> up, down;
+            while (dep[u] > dep[v])
+                up.push_back(u), u = par[u];
+            while (dep[v] > dep[u])
+                down.push_back(v), v = par[v];
+            while (u != v)
+                up.push_back(u), down.push_back(v), u = par[u], v = par[v];
+            if (!edge)
+                up.push_back(u);
+            up.insert(up.end(), down.rbegin(), down.rend());
+            return up;
+        };
+        auto inSubtree = [&](i32 v, i32 x) {
+            while (x != -1 && x != v)
+                x = par[x];
+            return x == v;
+        };
+
+        std::vector<Affine> A(N);
+        std::vector<Ends> B(N);
+        rep(v, 0, N) {
+            A[v] = {RandUtil::randInt(1, 100), RandUtil::randInt(0, 100)};
+            i64 x = RandUtil::randInt(-100, 100);
+            B[v] = {x, x, x};
+        }
+        TreePathQuery<Affine, affineOp, affineE> tpq(G, A, root, edge);
+        LazyTreePathQuery<Ends, endsOp, endsE, i64, endsMapping,
+                          addComposition, addId>
+            lazy(G, B, root, edge);
+        const auto &hld = tpq.hld();
+
+        rep(q, 0, 300) {
+            i32 u = RandUtil::randInt(0, N - 1), v = RandUtil::randInt(0, N - 1);
+            i32 type = RandUtil::randInt(0, 4);
+            if (type == 0) {
+                A[u] = {RandUtil::randInt(1, 100), RandUtil::randInt(0, 100)};
+                tpq.set(u, A[u]);
+                i64 x = RandUtil::randInt(-100, 100);
+                B[v] = {x, x, x};
+                lazy.set(v, B[v]);
+            } else if (type == 1) {
+                i64 f = RandUtil::randInt(-10, 10);
+                lazy.apply(u, v, f);
+                for (i32 x : walk(u, v))
+                    B[x] = endsMapping(f, B[x]);
+            } else if (type == 2) {
+                i64 f = RandUtil::randInt(-10, 10);
+                lazy.subtreeApply(u, f);
+                rep(x, 0, N) {
+                    if (inSubtree(u, x) && !(edge && x == u))
+                        B[x] = endsMapping(f, B[x]);
+                }
+            }
+            Affine ea = affineE();
+            Ends eb = endsE();
+            for (i32 x : walk(u, v))
+                ea = affineOp(ea, A[x]), eb = endsOp(eb, B[x]);
+            EQ(tpq.prod(u, v), ea);
+            EQ(lazy.prod(u, v), eb);
+            EQ(tpq.get(u), A[u]);
+            EQ(lazy.get(v), B[v]);
+
+            // 部分木は HLD の行きがけ順に掛ける
+            auto [l, r] = hld.node(u);
+            std::vector<i32> at(N);
+            rep(x, 0, N) at[hld.node(x).first] = x;
+            ea = affineE(), eb = endsE();
+            rep(i, l + edge, r) {
+                ea = affineOp(ea, A[at[i]]);
+                eb = endsOp(eb, B[at[i]]);
+            }
+            EQ(tpq.subtreeProd(u), ea);
+            EQ(lazy.subtreeProd(u), eb);
+        }
+    }
+}
+
+TEST(GRAPH, CENTROID_DECOMPOSITION) {
+    rep(iter, 0, 30) {
+        // 森も試す
+        i32 N = RandUtil::randInt(1, 300), M = 0;
+        Graph<WEIGHTED, UNDIRECTED> G(N, N - 1);
+        rep(i, 1, N) {
+            if (RandUtil::randInt(0, 19) == 0)
+                continue;
+            // 半分は長いパスを多く含む木にする
+            bool spine = (iter % 2 == 1 && i % 3 != 0);
+            i32 p = (spine ? i - 1 : RandUtil::randInt(0, i - 1));
+            G.addEdge(p, i, RandUtil::randInt(0, 100));
+            ++M;
+        }
+        CentroidDecomposition cd(G, iter % 3 + 1);
+        std::vector<std::vector<i64>> dist(N);
+        rep(s, 0, N) dist[s] = std::get<2>(naiveTree(G, (i32)s));
+
+        // 重心木の部分木の大きさは親の半分以下
+        std::vector<i32> sz(N, 1);
+        std::vector<i32> ord(N);
+        std::iota(all(ord), 0);
+        std::sort(all(ord), [&](i32 a, i32 b) {
+            return cd.level(a) > cd.level(b);
+        });
+        for (i32 v : ord)
+            if (cd.parent(v) != -1)
+                sz[cd.parent(v)] += sz[v];
+        i32 num_roots = 0;
+        rep(v, 0, N) {
+            i32 p = cd.parent(v);
+            if (p == -1) {
+                ++num_roots;
+                EQ(cd.level(v), 0);
+            } else {
+                EQ(cd.level(v), cd.level(p) + 1);
+                EQ((sz[v] * 2 <= sz[p]), true);
+            }
+            // 祖先と距離は段の順に並ぶ
+            i32 c = v;
+            for (i32 k = cd.level(v); k >= 0; --k, c = cd.parent(c)) {
+                EQ(cd.ancestor(v, k), c);
+                EQ(cd.distance(v, k), dist[v][c]);
+            }
+        }
+        EQ(num_roots, N - M);
+
+        std::vector<bool> marked(N, false);
+        rep(q, 0, 200) {
+            i32 v = RandUtil::randInt(0, N - 1);
+            if (RandUtil::randInt(0, 2) == 0) {
+                cd.mark(v);
+                marked[v] = true;
+            } else if (q == 100) {
+                cd.clearMarks();
+                marked.assign(N, false);
+            }
+            i64 expected = cd.CMAX;
+            rep(u, 0, N) {
+                if (marked[u] && dist[v][u] != -1)
+                    expected = std::min(expected, dist[v][u]);
+            }
+            EQ(cd.nearestMarked(v), expected);
+        }
+    }
+}
+
 int main() {
     RunAllTests<false>();
     return 0;